@@ -0,0 +1,117 @@
+#include "AudioOutput.h"
+#include <iostream>
+
+namespace {
+
+constexpr double LATENCY_FRAMES = 2;
+constexpr double MAX_LAG_FRAMES = 6;
+constexpr float GAIN_STEP = 1.0f / (AUDIO_SAMPLE_RATE * 0.002f);
+
+// Polynomial band-limited step, removes the aliasing of a naive square wave.
+double polyBlep(double t, double dt) {
+    if(t < dt) {
+        t /= dt;
+        return t + t - t * t - 1.0;
+    }
+    if(t > 1.0 - dt) {
+        t = (t - 1.0) / dt;
+        return t * t + t + t + 1.0;
+    }
+    return 0.0;
+}
+
+}
+
+AudioOutput::AudioOutput() {
+    SDL_AudioSpec desired {};
+    desired.freq = AUDIO_SAMPLE_RATE;
+    desired.format = AUDIO_F32SYS;
+    desired.channels = 1;
+    desired.samples = AUDIO_BUFFER_SAMPLES;
+    desired.callback = &AudioOutput::callback;
+    desired.userdata = this;
+    device = SDL_OpenAudioDevice(NULL, 0, &desired, NULL, 0);
+    if(device == 0) {
+        std::cerr << "SDL audio failure. Error: " << SDL_GetError() << std::endl;
+        return;
+    }
+    SDL_PauseAudioDevice(device, 0);
+}
+
+AudioOutput::~AudioOutput() {
+    if(device != 0)
+        SDL_CloseAudioDevice(device);
+}
+
+bool AudioOutput::isOpen() const {
+    return device != 0;
+}
+
+BuzzerRing *AudioOutput::getRing() {
+    return &ring;
+}
+
+void AudioOutput::setCyclesPerSecond(double _cyclesPerSecond) {
+    cyclesPerSecond = _cyclesPerSecond;
+}
+
+void AudioOutput::setMuted(bool _muted) {
+    muted = _muted;
+}
+
+void AudioOutput::publishCycle(uint64_t cycle) {
+    latestCycle.store(cycle, std::memory_order_release);
+}
+
+void AudioOutput::callback(void *userdata, Uint8 *stream, int length) {
+    auto audio = static_cast<AudioOutput *>(userdata);
+    audio->fill(reinterpret_cast<float *>(stream), length / sizeof(float));
+}
+
+void AudioOutput::fill(float *samples, int count) {
+    auto latest = latestCycle.load(std::memory_order_acquire);
+    double cyclesPerFrame = cyclesPerSecond.load() / 60;
+    double cyclesPerSample = cyclesPerSecond.load() / AUDIO_SAMPLE_RATE;
+
+    if(muted.load() || cursorCycle + MAX_LAG_FRAMES * cyclesPerFrame < latest
+        || cursorCycle > latest + cyclesPerFrame) {
+        resync(latest, LATENCY_FRAMES * cyclesPerFrame);
+    }
+
+    double phaseIncrement = BUZZER_FREQUENCY / AUDIO_SAMPLE_RATE;
+    for(int i = 0; i < count; ++i) {
+        const BuzzerEvent *event;
+        while((event = ring.peek()) != nullptr && event->cycle <= cursorCycle) {
+            level = event->on;
+            ring.pop();
+        }
+        bool starved = cursorCycle >= latest;
+        bool audible = level && !starved && !muted.load(std::memory_order_relaxed);
+        gain += audible ? GAIN_STEP : -GAIN_STEP;
+        gain = gain < 0 ? 0 : (gain > 1 ? 1 : gain);
+
+        samples[i] = gain > 0 ? BUZZER_VOLUME * gain * square(phaseIncrement) : 0.0f;
+        if(!starved)
+            cursorCycle += cyclesPerSample;
+    }
+}
+
+void AudioOutput::resync(uint64_t latest, double latencyCycles) {
+    cursorCycle = latest > latencyCycles ? latest - latencyCycles : 0;
+    const BuzzerEvent *event;
+    while((event = ring.peek()) != nullptr && event->cycle <= cursorCycle) {
+        level = event->on;
+        ring.pop();
+    }
+}
+
+float AudioOutput::square(double phaseIncrement) {
+    double value = phase < 0.5 ? 1.0 : -1.0;
+    value += polyBlep(phase, phaseIncrement);
+    double shifted = phase + 0.5;
+    shifted -= shifted >= 1.0 ? 1.0 : 0.0;
+    value -= polyBlep(shifted, phaseIncrement);
+    phase += phaseIncrement;
+    phase -= phase >= 1.0 ? 1.0 : 0.0;
+    return value;
+}
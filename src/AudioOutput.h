@@ -0,0 +1,40 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <cstdint>
+#include "core/Buzzer.h"
+
+#define AUDIO_SAMPLE_RATE 48000
+#define AUDIO_BUFFER_SAMPLES 256
+#define BUZZER_FREQUENCY 440.0
+#define BUZZER_VOLUME 0.2f
+
+// Plays the buzzer transitions the core pushes into a BuzzerRing. The SDL
+// callback follows the guest cycle counter a fixed distance behind the
+// emulator and never locks or allocates.
+class AudioOutput {
+    SDL_AudioDeviceID device = 0;
+    BuzzerRing ring;
+    std::atomic<uint64_t> latestCycle {0};
+    std::atomic<double> cyclesPerSecond {700};
+    std::atomic<bool> muted {false};
+
+    double cursorCycle = 0;
+    bool level = false;
+    double phase = 0;
+    float gain = 0;
+
+    static void callback(void *userdata, Uint8 *stream, int length);
+    void fill(float *samples, int count);
+    void resync(uint64_t latest, double latencyCycles);
+    float square(double phaseIncrement);
+
+    public:
+    AudioOutput();
+    ~AudioOutput();
+    bool isOpen() const;
+    BuzzerRing *getRing();
+    void setCyclesPerSecond(double cyclesPerSecond);
+    void setMuted(bool muted);
+    void publishCycle(uint64_t cycle);
+};
@@ -0,0 +1,304 @@
+#include "DebuggerConsole.h"
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+
+namespace {
+
+constexpr size_t SEARCH_LIST_LIMIT = 32;
+
+uint16_t parseNumber(const std::string &text) {
+    return std::stoi(text, nullptr, 16);
+}
+
+int parseRegister(const std::string &text) {
+    if(text == "I" || text == "i")
+        return DEBUGGER_REGISTER_I;
+    if(text.size() == 2 && (text[0] == 'V' || text[0] == 'v'))
+        return std::stoi(text.substr(1), nullptr, 16);
+    throw std::invalid_argument("unknown register " + text);
+}
+
+// Addresses wrap in peekMemory and anything from SEARCH_REGISTER_BASE up
+// reads a register, so only real memory and V0-VF are accepted
+uint32_t parseLocation(const std::string &text, size_t memorySize) {
+    if(text.size() == 2 && (text[0] == 'V' || text[0] == 'v'))
+        return SEARCH_REGISTER_BASE + parseRegister(text);
+    auto location = std::stoul(text, nullptr, 16);
+    if(location >= memorySize)
+        throw std::invalid_argument("location " + text + " is outside memory");
+    return location;
+}
+
+std::string formatLocation(uint32_t location) {
+    // "V" and a full uint32 in hex
+    char text[10];
+    if(location >= SEARCH_REGISTER_BASE)
+        snprintf(text, sizeof(text), "V%X", location - SEARCH_REGISTER_BASE);
+    else
+        snprintf(text, sizeof(text), "%03X", location);
+    return text;
+}
+
+SearchComparison parseSearchComparison(const std::string &text) {
+    static const std::pair<const char *, SearchComparison> names[] = {
+        {"eq", SearchComparison::EQUAL},
+        {"ne", SearchComparison::NOT_EQUAL},
+        {"lt", SearchComparison::LESS},
+        {"gt", SearchComparison::GREATER},
+        {"changed", SearchComparison::CHANGED},
+        {"same", SearchComparison::UNCHANGED},
+        {"inc", SearchComparison::INCREASED},
+        {"dec", SearchComparison::DECREASED}
+    };
+    for(auto &name: names) {
+        if(text == name.first)
+            return name.second;
+    }
+    throw std::invalid_argument("unknown search " + text);
+}
+
+Comparison parseComparison(const std::string &text) {
+    if(text == "==")
+        return Comparison::EQUAL;
+    if(text == "!=")
+        return Comparison::NOT_EQUAL;
+    if(text == "<")
+        return Comparison::LESS;
+    if(text == ">")
+        return Comparison::GREATER;
+    throw std::invalid_argument("unknown comparison " + text);
+}
+
+}
+
+DebuggerConsole::DebuggerConsole(Debugger &_debugger, Chip8 &_chip8, MemorySearch &_memorySearch):
+    debugger(_debugger),
+    chip8(_chip8),
+    memorySearch(_memorySearch),
+    reader(&DebuggerConsole::readerLoop, this) {
+    reader.detach();
+    std::cout << "Debugger console ready, type help for commands" << std::endl;
+}
+
+void DebuggerConsole::readerLoop() {
+    std::string line;
+    while(std::getline(std::cin, line)) {
+        std::lock_guard<std::mutex> lock(linesMutex);
+        pendingLines.push_back(line);
+    }
+}
+
+void DebuggerConsole::poll() {
+    std::deque<std::string> lines;
+    {
+        std::lock_guard<std::mutex> lock(linesMutex);
+        lines.swap(pendingLines);
+    }
+    for(auto &line: lines) {
+        try {
+            execute(line);
+        } catch(const std::exception &e) {
+            std::cout << "Invalid command: " << e.what() << std::endl;
+        }
+    }
+    if(auto message = debugger.takeStopMessage()) {
+        std::cout << message.value() << std::endl;
+        printRegisters();
+    }
+}
+
+void DebuggerConsole::execute(const std::string &line) {
+    std::istringstream arguments(line);
+    std::string command;
+    if(!(arguments >> command))
+        return;
+
+    if(command == "break" || command == "b") {
+        addBreakpoint(arguments);
+    } else if(command == "watch" || command == "w") {
+        addWatchpoint(arguments);
+    } else if(command == "delete" || command == "d") {
+        int id;
+        arguments >> id;
+        if(!debugger.remove(id))
+            std::cout << "No breakpoint or watchpoint " << id << std::endl;
+    } else if(command == "list" || command == "l") {
+        printList();
+    } else if(command == "continue" || command == "c") {
+        debugger.resume();
+    } else if(command == "step" || command == "s") {
+        int count = 1;
+        arguments >> count;
+        debugger.step(count);
+    } else if(command == "pause" || command == "p") {
+        debugger.pause();
+    } else if(command == "regs" || command == "r") {
+        printRegisters();
+    } else if(command == "mem" || command == "m") {
+        printMemory(arguments);
+    } else if(command == "search") {
+        search(arguments);
+    } else if(command == "name") {
+        nameLocation(arguments);
+    } else if(command == "names") {
+        printNames();
+    } else {
+        printHelp();
+    }
+}
+
+void DebuggerConsole::addBreakpoint(std::istringstream &arguments) {
+    std::optional<uint16_t> address;
+    std::optional<BreakpointCondition> condition;
+    std::string token;
+    arguments >> token;
+    if(token != "if") {
+        address = parseNumber(token);
+        token.clear();
+        arguments >> token;
+    }
+    if(token == "if") {
+        std::string reg, comparison, value;
+        arguments >> reg >> comparison >> value;
+        condition = BreakpointCondition {
+            parseRegister(reg), parseComparison(comparison), parseNumber(value)};
+    }
+    if(!address && !condition)
+        throw std::invalid_argument("break needs an address or a condition");
+    std::cout << "Breakpoint " << debugger.addBreakpoint(address, condition) << std::endl;
+}
+
+void DebuggerConsole::addWatchpoint(std::istringstream &arguments) {
+    std::string mode = "rw";
+    std::string range;
+    arguments >> range;
+    if(range == "r" || range == "w" || range == "rw") {
+        mode = range;
+        arguments >> range;
+    }
+    auto separator = range.find('-');
+    uint16_t first = parseNumber(range.substr(0, separator));
+    uint16_t last = separator == std::string::npos
+        ? first
+        : parseNumber(range.substr(separator + 1));
+    auto id = debugger.addWatchpoint(first, last,
+        mode.find('r') != std::string::npos,
+        mode.find('w') != std::string::npos);
+    std::cout << "Watchpoint " << id << std::endl;
+}
+
+void DebuggerConsole::printList() {
+    std::cout << std::hex << std::uppercase;
+    for(auto &breakpoint: debugger.getBreakpoints()) {
+        std::cout << std::dec << breakpoint.id << std::hex << ": break";
+        if(breakpoint.address)
+            std::cout << " " << breakpoint.address.value();
+        if(breakpoint.condition) {
+            auto &condition = breakpoint.condition.value();
+            static const char *comparisons[] = {"==", "!=", "<", ">"};
+            std::cout << " if ";
+            if(condition.reg == DEBUGGER_REGISTER_I)
+                std::cout << "I";
+            else
+                std::cout << "V" << condition.reg;
+            std::cout << " " << comparisons[static_cast<int>(condition.comparison)]
+                << " " << condition.value;
+        }
+        std::cout << std::endl;
+    }
+    for(auto &watchpoint: debugger.getWatchpoints()) {
+        std::cout << std::dec << watchpoint.id << std::hex << ": watch "
+            << (watchpoint.onRead ? "r" : "") << (watchpoint.onWrite ? "w" : "")
+            << " " << watchpoint.first << "-" << watchpoint.last << std::endl;
+    }
+    std::cout << std::dec << std::nouppercase;
+}
+
+void DebuggerConsole::printRegisters() {
+    std::cout << std::hex << std::uppercase << std::setfill('0')
+        << "PC=" << std::setw(3) << chip8.getProgramCounter()
+        << " I=" << std::setw(3) << chip8.getIndexPointer();
+    for(int i = 0; i < 16; ++i) {
+        std::cout << " V" << i << "=" << std::setw(2) << (int)chip8.getRegister(i);
+    }
+    std::cout << std::dec << std::nouppercase << std::setfill(' ') << std::endl;
+}
+
+void DebuggerConsole::printMemory(std::istringstream &arguments) {
+    std::string address, length = "10";
+    arguments >> address >> length;
+    uint16_t first = parseNumber(address);
+    uint16_t count = parseNumber(length);
+    std::cout << std::hex << std::uppercase << std::setfill('0');
+    for(uint16_t i = 0; i < count; ++i) {
+        if(i % 16 == 0)
+            std::cout << (i ? "\n" : "") << std::setw(3) << first + i << ":";
+        std::cout << " " << std::setw(2) << (int)chip8.peekMemory(first + i);
+    }
+    std::cout << std::dec << std::nouppercase << std::setfill(' ') << std::endl;
+}
+
+void DebuggerConsole::search(std::istringstream &arguments) {
+    std::string mode, operand;
+    arguments >> mode >> operand;
+    if(mode == "start") {
+        memorySearch.start(chip8);
+    } else if(mode == "list") {
+        std::cout << std::hex << std::uppercase << std::setfill('0');
+        for(auto location: memorySearch.getCandidates(SEARCH_LIST_LIMIT)) {
+            std::cout << formatLocation(location) << ": "
+                << std::setw(2) << (int)memorySearch.getPreviousValue(location) << " -> "
+                << std::setw(2) << (int)memorySearch.getCurrentValue(location) << std::endl;
+        }
+        std::cout << std::dec << std::nouppercase << std::setfill(' ');
+    } else {
+        auto comparison = parseSearchComparison(mode);
+        // inc N and dec N look for a change by exactly N
+        if(!operand.empty() && comparison == SearchComparison::INCREASED)
+            comparison = SearchComparison::INCREASED_BY;
+        if(!operand.empty() && comparison == SearchComparison::DECREASED)
+            comparison = SearchComparison::DECREASED_BY;
+        memorySearch.filter(chip8, comparison, operand.empty() ? 0 : parseNumber(operand));
+    }
+    std::cout << memorySearch.getCandidateCount() << " candidates" << std::endl;
+}
+
+void DebuggerConsole::nameLocation(std::istringstream &arguments) {
+    std::string name, location;
+    arguments >> name >> location;
+    if(name.empty())
+        throw std::invalid_argument("name needs a name");
+    if(location.empty()) {
+        if(!memorySearch.removeWatch(name))
+            std::cout << "No location named " << name << std::endl;
+        return;
+    }
+    memorySearch.setWatch(name, parseLocation(location, chip8.getMemorySize()));
+}
+
+void DebuggerConsole::printNames() {
+    std::cout << std::hex << std::uppercase << std::setfill('0');
+    for(auto &watch: memorySearch.getWatches()) {
+        std::cout << watch.name << " " << formatLocation(watch.location) << " = "
+            << std::setw(2) << (int)readLocation(chip8, watch.location) << std::endl;
+    }
+    std::cout << std::dec << std::nouppercase << std::setfill(' ');
+}
+
+void DebuggerConsole::printHelp() {
+    std::cout << "Commands (numbers are hex):\n"
+        << "  break ADDR [if REG OP VALUE]   REG is V0-VF or I, OP is == != < >\n"
+        << "  break if REG OP VALUE          break anywhere when condition holds\n"
+        << "  watch [r|w|rw] ADDR[-ADDR]     stop on memory read or write\n"
+        << "  delete ID, list\n"
+        << "  continue, step [N], pause\n"
+        << "  regs, mem ADDR [LEN]\n"
+        << "  search start                   snapshot memory and V0-VF, all are candidates\n"
+        << "  search eq|ne|lt|gt VALUE       keep candidates compared with VALUE\n"
+        << "  search changed|same|inc|dec    keep candidates compared with the last search\n"
+        << "  search inc|dec N               keep candidates changed by exactly N\n"
+        << "  search list                    show candidates, old and new value\n"
+        << "  name NAME ADDR|Vx, name NAME   name a location (exported with --shm), unname it\n"
+        << "  names                          show named locations and values" << std::endl;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "core/Debugger.h"
+#include "core/MemorySearch.h"
+
+class DebuggerConsole {
+    Debugger &debugger;
+    Chip8 &chip8;
+    MemorySearch &memorySearch;
+    std::mutex linesMutex;
+    std::deque<std::string> pendingLines;
+    std::thread reader;
+
+    void readerLoop();
+    void execute(const std::string &line);
+    void addBreakpoint(std::istringstream &arguments);
+    void addWatchpoint(std::istringstream &arguments);
+    void printList();
+    void printRegisters();
+    void printMemory(std::istringstream &arguments);
+    void search(std::istringstream &arguments);
+    void nameLocation(std::istringstream &arguments);
+    void printNames();
+    void printHelp();
+
+    public:
+    DebuggerConsole(Debugger &debugger, Chip8 &chip8, MemorySearch &memorySearch);
+    void poll();
+};
@@ -2,25 +2,129 @@
 #include <chrono>
 #include <vector>
 #include <string>
-#include <fstream>
 #include <stdexcept>
 #include <thread>
 #include <iomanip>
 #include <iostream>
 #include <SDL2/SDL.h>
 #include <memory>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
 
-Frame::Frame(std::string romFilePath, CHIP8_IMPLEMENTATION impl):
+Frame::Frame(const RomImage &rom, CHIP8_IMPLEMENTATION impl):
     chip8(std::unique_ptr<Chip8>(Chip8Factory::make(impl, keyboard))),
+    implementation(impl),
     shouldQuit(false) {
+    RomLoader::checkFits(rom, impl);
     tryToInitializeSDL();
     screen = std::make_unique<Screen>(WINDOW_WIDTH, WINDOW_HEIGHT);
-    auto romData = loadRomFile(romFilePath);
-    chip8->loadRom(romData);
+    overlay = std::make_unique<PerformanceOverlay>(screen->getWindow(), screen->getRenderer());
+    audio = std::make_unique<AudioOutput>();
+    if(audio->isOpen()) {
+        chip8->setBuzzer(audio->getRing());
+        audio->setCyclesPerSecond(instructionsPerFrame * SCREEN_REFRESH_FREQUENCY);
+    }
+    chip8->setTrapPolicy(trapPolicy);
+    chip8->loadRom(rom.data);
     initializeKeyboard();
 }
 
+void Frame::setInstructionsPerFrame(int _instructionsPerFrame) {
+    instructionsPerFrame = std::max(_instructionsPerFrame, 1);
+    audio->setCyclesPerSecond(instructionsPerFrame * SCREEN_REFRESH_FREQUENCY);
+}
+
+void Frame::setTrapPolicy(CHIP8_TRAP_POLICY policy) {
+    trapPolicy = policy;
+    chip8->setTrapPolicy(policy);
+}
+
+void Frame::setRunAhead(unsigned int frames) {
+    runAheadFrames = std::min(frames, (unsigned int)MAX_RUN_AHEAD_FRAMES);
+}
+
+// Frames run for the implementation's cycle budget instead of a fixed number
+// of instructions, so guest speed follows the instruction mix.
+void Frame::enableCycleTiming() {
+    cycleBudget = chip8->getTiming().cyclesPerFrame;
+    if(cycleBudget == 0) {
+        std::cout << Chip8Factory::toName(implementation)
+            << " has no cycle timing, running " << instructionsPerFrame << " instructions per frame" << std::endl;
+    }
+}
+
+void Frame::setKeyMapping(const char keyMapping[16]) {
+    for(int key = CHIP8_0; key <= CHIP8_F; ++key) {
+        if(keyMapping[key] == 0)
+            continue;
+        auto scancode = SDL_GetScancodeFromKey(std::tolower(keyMapping[key]));
+        if(scancode == SDL_SCANCODE_UNKNOWN)
+            continue;
+        for(auto mapping = sdlToChip8KeyMap.begin(); mapping != sdlToChip8KeyMap.end();) {
+            if(mapping->second == key)
+                mapping = sdlToChip8KeyMap.erase(mapping);
+            else
+                ++mapping;
+        }
+        sdlToChip8KeyMap[scancode] = static_cast<CHIP8_KEY>(key);
+    }
+}
+
+void Frame::enableTrace(std::string traceFilePath, bool compressed) {
+    traceWriter = std::make_unique<TraceWriter>(traceFilePath, compressed);
+    traceRing = traceWriter->registerProducer();
+    chip8->setTracer(traceRing);
+}
+
+void Frame::enableCapture(std::string captureFilePath) {
+    captureWriter = std::make_unique<CaptureWriter>(captureFilePath);
+}
+
+void Frame::enableSharedState(std::string name) {
+    sharedState = std::make_unique<SharedStateExport>(name);
+}
+
+// Records from the current state on, so call it once the rom is loaded and
+// the trap policy is set.
+void Frame::enableReplay(std::string replayFilePath) {
+    replayWriter = std::make_unique<ReplayWriter>(replayFilePath, implementation, trapPolicy, *chip8);
+}
+
+// Both peers must run the same rom with the same instructions per frame.
+// Each player only controls their half of the keypad, whatever keys
+// sdlToChip8KeyMap sends there.
+void Frame::enableNetplay(int player, std::string localAddress, std::string peerAddress) {
+    if(player < 1 || player > 2)
+        throw std::runtime_error("netplay player must be 1 or 2");
+    netplaySocket = std::make_unique<NetplaySocket>(localAddress, peerAddress);
+    rollbackSession = std::make_unique<RollbackSession>(*chip8, keyboard, instructionsPerFrame);
+    localPlayerKeys = NETPLAY_PLAYER_KEYS[player - 1];
+}
+
+void Frame::enableDebugger() {
+    debugger = std::make_unique<Debugger>(*chip8);
+    debuggerConsole = std::make_unique<DebuggerConsole>(*debugger, *chip8, memorySearch);
+}
+
+void Frame::enableWatch(std::string romFilePath, bool replayInput) {
+    romWatcher = std::make_unique<RomWatcher>(romFilePath);
+    watchedRomFilePath = romFilePath;
+    replayInputOnReload = replayInput;
+    // The replayed prefix only lands at the same point if CXNN repeats too
+    if(replayInput)
+        chip8->seedRandom(WATCH_REPLAY_RANDOM_SEED);
+}
+
 Frame::~Frame() {
+    if(rollbackSession) {
+        std::cout << "Netplay: " << rollbackSession->getRollbackCount() << " rollbacks, "
+            << rollbackSession->getReplayedFrames() << " frames replayed" << std::endl;
+    }
+    chip8->setBuzzer(nullptr);
+    audio.reset();
+    overlay.reset();
+    screen.reset();
     SDL_Quit();
 }
 
@@ -30,60 +134,243 @@ void Frame::tryToInitializeSDL() {
             << SDL_GetError()
             << std::endl;
     }
+    if(SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+        std::cerr << "SDL audio init error: "
+            << SDL_GetError()
+            << std::endl;
+    }
 }
 
 
 void Frame::startLoop() {
-    lastScreenUpdate = Clock::now();
+    auto nextFrame = Clock::now();
     while(!shouldQuit) {
         auto frameStarted = Clock::now();
         processEventQueue();
-        try {
-            chip8->doNextCycle();
-        } catch (InstructionNotImplemented e) {
-            std::cout << "Could not execute instruction: " << std::hex << e.getOpcode() << std::endl;
+        if(sharedState)
+            sharedState->applyInput(keyboard);
+        if(debuggerConsole)
+            debuggerConsole->poll();
+        if(romWatcher && romWatcher->hasChanged()) {
+            reloadRom();
+            if(replayWriter)
+                replayWriter->checkpoint(*chip8);
         }
+        auto frameKeys = toKeyMask(keyboard);
+        if(romWatcher && replayInputOnReload && !inputPrefixFrozen)
+            inputPrefix.push_back(frameKeys);
+        auto instructionsExecuted = rollbackSession ? runNetplayFrame() : runFrame();
+        if(replayWriter)
+            replayWriter->addFrame(*chip8, frameKeys,
+                frameStalled ? REPLAY_FRAME_STALLED : instructionsExecuted);
+        auto pixels = chip8->peek();
+        auto displayedPixels = runAheadFrames > 0 ? runAhead() : pixels;
+        auto emulationFinished = Clock::now();
+
+        screen->update(displayedPixels);
+        if(captureWriter)
+            captureWriter->addFrame(pixels);
+        if(sharedState)
+            sharedState->publish(*chip8, pixels, toKeyMask(keyboard), memorySearch.getWatches());
+        auto renderFinished = Clock::now();
+        overlay->draw(performanceStats);
+        screen->present();
 
-        if(Clock::now() - lastScreenUpdate
-            > std::chrono::duration<float>(1/SCREEN_REFRESH_FREQUENCY)) {
-            screen->update(chip8->peek());
+        nextFrame += FRAME_PERIOD;
+        auto sleepStarted = Clock::now();
+        std::this_thread::sleep_until(nextFrame);
+        auto wokeUp = Clock::now();
+        auto sleepOvershoot = wokeUp - nextFrame;
+        if(sleepOvershoot > FRAME_PERIOD) {
+            nextFrame = wokeUp;
         }
-        auto sleepDuration = CHIP_CLOCK_PERIOD - (Clock::now() - frameStarted);
-        std::this_thread::sleep_for(sleepDuration);
+
+        if(cycleBudget > 0)
+            performanceStats.recordGuestLoad(frameCycles, cycleBudget);
+        performanceStats.recordFrame(instructionsExecuted,
+            emulationFinished - frameStarted,
+            renderFinished - emulationFinished,
+            sleepStarted - frameStarted,
+            wokeUp - sleepStarted,
+            std::max(sleepOvershoot, Clock::duration(0)));
     }
 }
 
-Chip8Rom Frame::loadRomFile(std::string filePath) {
-    if(determineFileSize(filePath) > CHIP8_MAX_PROGRAM_SIZE) {
-        throw RomFileTooLargeException();
+int Frame::runFrame() {
+    auto instructionsExecuted = executeFrame();
+    if(instructionsExecuted > 0 || frameStalled)
+        chip8->tickTimers();
+    // The buzzer is placed by instruction count, which varies under a budget
+    if(cycleBudget > 0 && instructionsExecuted > 0)
+        audio->setCyclesPerSecond(instructionsExecuted * SCREEN_REFRESH_FREQUENCY);
+    audio->publishCycle(chip8->getCycleCount());
+    return instructionsExecuted;
+}
+
+// Stalls (runs nothing) while the peer is more than ROLLBACK_WINDOW frames
+// behind, so a mispredicted frame can always still be replayed.
+int Frame::runNetplayFrame() {
+    while(netplaySocket->receive(netplayPacket))
+        rollbackSession->readPacket(netplayPacket.data(), netplayPacket.size());
+    if(rollbackSession->hasPendingRollback()) {
+        // Replayed frames were heard the first time round
+        chip8->setBuzzer(nullptr);
+        rollbackSession->rollback();
+        if(audio->isOpen())
+            chip8->setBuzzer(audio->getRing());
     }
-    std::ifstream file(filePath);
-    if(!file.good()) {
-        throw InvalidFileException();
+    int instructionsExecuted = 0;
+    if(rollbackSession->advance(toKeyMask(keyboard) & localPlayerKeys))
+        instructionsExecuted = instructionsPerFrame;
+    rollbackSession->writePacket(netplayPacket);
+    netplaySocket->send(netplayPacket);
+    audio->publishCycle(chip8->getCycleCount());
+    return instructionsExecuted;
+}
+
+// Shows the screen runAheadFrames frames into the future, as if the keys held
+// now stayed held, then rewinds. Games that only poll the keypad every few
+// frames answer on the next displayed frame. Capture and --shm still see the
+// real frame; trace, sound and trap logging are off while speculating.
+PixelMatrix Frame::runAhead() {
+    if(chip8->isHalted() || (debugger && debugger->isArmed()))
+        return chip8->peek();
+    chip8->saveState(runAheadState);
+    chip8->setTracer(nullptr);
+    chip8->setBuzzer(nullptr);
+    if(trapPolicy == CHIP8_TRAP_LOG)
+        chip8->setTrapPolicy(CHIP8_TRAP_SKIP);
+    auto debt = cycleDebt;
+    for(unsigned int frame = 0; frame < runAheadFrames; ++frame) {
+        uint32_t budget = 0;
+        if(cycleBudget > 0) {
+            budget = takeCycleBudget(debt);
+            if(budget == 0) {
+                chip8->tickTimers();
+                continue;
+            }
+        }
+        auto status = runGuest(budget);
+        if(status.halted)
+            break;
+        if(status.cycles > budget)
+            debt = status.cycles - budget;
+        chip8->tickTimers();
     }
-    Chip8Rom data;
-    int i = 0;
-    while(file.good()) {
-        data[i] = file.get();
-        ++i;
+    auto pixels = chip8->peek();
+    chip8->restoreState(runAheadState);
+    chip8->setTrapPolicy(trapPolicy);
+    chip8->setTracer(traceRing);
+    if(audio->isOpen())
+        chip8->setBuzzer(audio->getRing());
+    return pixels;
+}
+
+void Frame::reloadRom() {
+    RomImage rom;
+    try {
+        rom = RomLoader::load(watchedRomFilePath);
+        RomLoader::checkFits(rom, implementation);
+    } catch(std::runtime_error &e) {
+        std::cout << "Could not reload rom: " << e.what() << std::endl;
+        return;
+    }
+    // Truncated by an editor that has not written the new rom yet
+    if(rom.size == 0) {
+        std::cout << "Could not reload rom: " << watchedRomFilePath << " is empty" << std::endl;
+        return;
     }
-    file.close();
-    return data;
+    chip8->reset();
+    cycleDebt = 0;
+    if(replayInputOnReload)
+        chip8->seedRandom(WATCH_REPLAY_RANDOM_SEED);
+    chip8->loadRom(rom.data);
+    std::cout << "Reloaded " << watchedRomFilePath << std::endl;
+
+    if(!replayInputOnReload) {
+        inputPrefix.clear();
+        return;
+    }
+    auto liveKeyboard = keyboard;
+    audio->setMuted(true);
+    for(auto keys: inputPrefix) {
+        applyKeyMask(keyboard, keys);
+        runFrame();
+    }
+    audio->setMuted(false);
+    keyboard = liveKeyboard;
+}
+
+int Frame::executeFrame() {
+    frameStalled = false;
+    frameCycles = 0;
+    if(debugger && debugger->isPaused())
+        return 0;
+    uint32_t budget = 0;
+    if(cycleBudget > 0) {
+        budget = takeCycleBudget(cycleDebt);
+        frameCycles = cycleBudget - budget;
+        if(budget == 0) {
+            frameStalled = true;
+            return 0;
+        }
+    }
+    if(debugger && debugger->isArmed()) {
+        if(budget == 0)
+            return debugger->runCycles(instructionsPerFrame);
+        uint32_t spent;
+        auto executed = debugger->runBudget(budget, spent);
+        settleCycleBudget(budget, spent);
+        return executed;
+    }
+    auto status = runGuest(budget);
+    if(budget > 0)
+        settleCycleBudget(budget, status.cycles);
+    if(status.halted && status.trap.fault != CHIP8_FAULT_NONE) {
+        char message[64];
+        snprintf(message, sizeof(message), "Halted on %s at %03X (%04X)",
+            describeFault(status.trap.fault), status.trap.programCounter, status.trap.opcode);
+        std::cout << message << std::endl;
+    }
+    return status.executed;
+}
+
+// The instruction that crosses the budget completes and is still executing
+// when the next frame starts, so its overrun comes off that frame's budget.
+// A debt of a whole frame or more leaves nothing to run.
+uint32_t Frame::takeCycleBudget(uint32_t &debt) const {
+    auto paid = std::min(debt, cycleBudget);
+    debt -= paid;
+    return cycleBudget - paid;
 }
 
-long Frame::determineFileSize(std::string filePath) {
-    std::ifstream file(filePath, std::ifstream::ate | std::ifstream::binary);
-    long size = file.tellg();
-    file.close();
-    return size;
+void Frame::settleCycleBudget(uint32_t budget, uint32_t spent) {
+    frameCycles += std::min(spent, budget);
+    cycleDebt = spent > budget ? spent - budget : 0;
+}
+
+// A zero budget runs instructionsPerFrame instructions
+Chip8RunStatus Frame::runGuest(uint32_t budget) {
+    if(budget > 0)
+        return chip8->runBudget(budget);
+    return chip8->run(instructionsPerFrame);
 }
 
 void Frame::processEventQueue() {
     SDL_Event e;
     while(SDL_PollEvent(&e)) {
+        if(overlay->processEvent(e))
+            continue;
         if(e.type == SDL_QUIT) {
             shouldQuit = true;
         } else if(e.type == SDL_KEYDOWN) {
+            if(romWatcher && replayInputOnReload && e.key.keysym.scancode == FREEZE_INPUT_PREFIX_HOTKEY) {
+                inputPrefixFrozen = !inputPrefixFrozen;
+                std::cout << (inputPrefixFrozen ? "Input prefix frozen at "
+                    : "Input prefix recording resumed at ")
+                    << inputPrefix.size() << " frames" << std::endl;
+                continue;
+            }
             if(!isChip8Key(e))
                 continue;
             keyboard[sdlToChip8KeyMap[e.key.keysym.scancode]] = true;
@@ -102,7 +389,5 @@ bool Frame::isChip8Key(const SDL_Event &e) const {
 }
 
 void Frame::initializeKeyboard() {
-    for(CHIP8_KEY key = CHIP8_0; key < CHIP8_F + 1; key = static_cast<CHIP8_KEY>(key + 1)) {
-        keyboard.insert({key, false});
-    }
+    keyboard.fill(false);
 }
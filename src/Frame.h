@@ -1,29 +1,63 @@
 #pragma once 
 #include "core/Chip8.h"
 #include "Screen.h"
+#include "ui/PerformanceOverlay.h"
+#include "ui/PerformanceStats.h"
 #include <unordered_map>
 #include "core/Chip8Factory.h"
+#include "core/Debugger.h"
+#include "core/RomLoader.h"
+#include "core/CaptureWriter.h"
+#include "DebuggerConsole.h"
+#include "RomWatcher.h"
+#include "AudioOutput.h"
+#include "SharedStateExport.h"
+#include "NetplaySocket.h"
+#include "core/Rollback.h"
+#include "core/Replay.h"
 
 #define WINDOW_WIDTH 640
 #define WINDOW_HEIGHT 320
 #define SCREEN_REFRESH_FREQUENCY 60
-
-typedef std::array<char, CHIP8_MAX_PROGRAM_SIZE> Chip8Rom;
-
-class RomFileTooLargeException: public std::runtime_error {
-    public:
-    RomFileTooLargeException():runtime_error("Rom file exceeded max size"){}
-};
-
-class InvalidFileException: public std::runtime_error {
-    public:
-    InvalidFileException():runtime_error("File does not exist or is corrupted"){}
-};
+#define CHIP_CLOCK_FREQUENCY 700
+#define FREEZE_INPUT_PREFIX_HOTKEY SDL_SCANCODE_F5
+#define WATCH_REPLAY_RANDOM_SEED 0xC8C8
+#define MAX_RUN_AHEAD_FRAMES 8
 
 class Frame {
 
     std::unique_ptr<Chip8> chip8;
+    std::unique_ptr<TraceWriter> traceWriter;
+    TraceRing *traceRing = nullptr;
+    std::unique_ptr<CaptureWriter> captureWriter;
+    std::unique_ptr<SharedStateExport> sharedState;
+    std::unique_ptr<ReplayWriter> replayWriter;
+    std::unique_ptr<NetplaySocket> netplaySocket;
+    std::unique_ptr<RollbackSession> rollbackSession;
+    std::vector<uint8_t> netplayPacket;
+    uint16_t localPlayerKeys = 0xFFFF;
+    MemorySearch memorySearch;
+    std::unique_ptr<Debugger> debugger;
+    std::unique_ptr<DebuggerConsole> debuggerConsole;
+    std::unique_ptr<RomWatcher> romWatcher;
+    std::string watchedRomFilePath;
+    bool replayInputOnReload = false;
+    bool inputPrefixFrozen = false;
+    std::vector<uint16_t> inputPrefix;
     std::unique_ptr<Screen> screen;
+    std::unique_ptr<PerformanceOverlay> overlay;
+    std::unique_ptr<AudioOutput> audio;
+    PerformanceStats performanceStats;
+    CHIP8_IMPLEMENTATION implementation;
+    CHIP8_TRAP_POLICY trapPolicy = CHIP8_TRAP_LOG;
+    unsigned int runAheadFrames = 0;
+    uint32_t cycleBudget = 0;
+    uint32_t frameCycles = 0;
+    // Cycles the last instruction ran past its frame's budget
+    uint32_t cycleDebt = 0;
+    // The frame was spent finishing an instruction from an earlier one
+    bool frameStalled = false;
+    Chip8State runAheadState;
     bool shouldQuit;
     typedef std::chrono::steady_clock Clock;
     Chip8Keyboard keyboard;
@@ -48,19 +82,37 @@ class Frame {
 
     };
 
-    static auto constexpr CHIP_CLOCK_PERIOD = std::chrono::seconds(1/700);
-
-    Clock::time_point lastScreenUpdate;
+    static auto constexpr FRAME_PERIOD = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / SCREEN_REFRESH_FREQUENCY));
+    int instructionsPerFrame = CHIP_CLOCK_FREQUENCY / SCREEN_REFRESH_FREQUENCY;
 
     void tryToInitializeSDL();
-    Chip8Rom loadRomFile(std::string filePath);
-    long determineFileSize(std::string filePath);
     void processEventQueue();
+    int runFrame();
+    int runNetplayFrame();
+    int executeFrame();
+    uint32_t takeCycleBudget(uint32_t &debt) const;
+    void settleCycleBudget(uint32_t budget, uint32_t spent);
+    Chip8RunStatus runGuest(uint32_t budget);
+    PixelMatrix runAhead();
+    void reloadRom();
     void initializeKeyboard();
     bool isChip8Key(const SDL_Event &e) const;
     public:
-    Frame(std::string romFilePath,
+    Frame(const RomImage &rom,
         CHIP8_IMPLEMENTATION impl = CHIP8_IMPLEMENTATION::ORIGINAL_CHIP8);
     ~Frame();
+    void setInstructionsPerFrame(int instructionsPerFrame);
+    void setKeyMapping(const char keyMapping[16]);
+    void setTrapPolicy(CHIP8_TRAP_POLICY policy);
+    void setRunAhead(unsigned int frames);
+    void enableCycleTiming();
+    void enableTrace(std::string traceFilePath, bool compressed);
+    void enableCapture(std::string captureFilePath);
+    void enableSharedState(std::string name);
+    void enableReplay(std::string replayFilePath);
+    void enableNetplay(int player, std::string localAddress, std::string peerAddress);
+    void enableDebugger();
+    void enableWatch(std::string romFilePath, bool replayInput);
     void startLoop();
 };
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "NetplaySocket.h"
+#include "core/Rollback.h"
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+const std::string UNIX_PREFIX = "unix:";
+
+bool isUnixAddress(const std::string &address) {
+    return address.compare(0, UNIX_PREFIX.size(), UNIX_PREFIX) == 0;
+}
+
+socklen_t resolve(const std::string &address, sockaddr_storage &result) {
+    if(isUnixAddress(address)) {
+        auto path = address.substr(UNIX_PREFIX.size());
+        sockaddr_un unixAddress {};
+        if(path.empty() || path.size() >= sizeof(unixAddress.sun_path))
+            throw NetplaySocketException(address);
+        unixAddress.sun_family = AF_UNIX;
+        memcpy(unixAddress.sun_path, path.c_str(), path.size());
+        memcpy(&result, &unixAddress, sizeof(unixAddress));
+        return sizeof(unixAddress);
+    }
+    auto separator = address.find_last_of(':');
+    if(separator == std::string::npos)
+        throw NetplaySocketException(address);
+    auto host = address.substr(0, separator);
+    auto port = address.substr(separator + 1);
+    addrinfo hints {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo *found = nullptr;
+    if(getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &found) != 0)
+        throw NetplaySocketException(address);
+    socklen_t length = found->ai_addrlen;
+    memcpy(&result, found->ai_addr, length);
+    freeaddrinfo(found);
+    return length;
+}
+
+}
+
+NetplaySocket::NetplaySocket(std::string localAddress, std::string _peerAddress) {
+    if(isUnixAddress(localAddress) != isUnixAddress(_peerAddress))
+        throw NetplaySocketException(_peerAddress);
+    sockaddr_storage local {};
+    socklen_t localLength = resolve(localAddress, local);
+    peerAddressLength = resolve(_peerAddress, peerAddress);
+
+    socketDescriptor = socket(local.ss_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(socketDescriptor < 0)
+        throw NetplaySocketException(localAddress);
+    if(isUnixAddress(localAddress)) {
+        boundPath = localAddress.substr(UNIX_PREFIX.size());
+        unlink(boundPath.c_str());
+    }
+    if(bind(socketDescriptor, reinterpret_cast<sockaddr *>(&local), localLength) < 0) {
+        close(socketDescriptor);
+        throw NetplaySocketException(localAddress);
+    }
+}
+
+NetplaySocket::~NetplaySocket() {
+    close(socketDescriptor);
+    if(!boundPath.empty())
+        unlink(boundPath.c_str());
+}
+
+// Datagrams that cannot be sent (peer not up yet, buffer full) are dropped;
+// the next packet repeats everything unacknowledged anyway.
+void NetplaySocket::send(const std::vector<uint8_t> &packet) {
+    sendto(socketDescriptor, packet.data(), packet.size(), 0,
+        reinterpret_cast<const sockaddr *>(&peerAddress), peerAddressLength);
+}
+
+bool NetplaySocket::receive(std::vector<uint8_t> &packet) {
+    packet.resize(NETPLAY_MAX_PACKET_SIZE);
+    auto length = recv(socketDescriptor, packet.data(), packet.size(), 0);
+    if(length < 0) {
+        packet.clear();
+        return false;
+    }
+    packet.resize(length);
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+
+class NetplaySocketException: public std::runtime_error {
+    public:
+    NetplaySocketException(std::string address):
+        runtime_error("Could not open netplay socket for " + address){}
+};
+
+// Non-blocking datagram socket between two peers. Addresses are host:port
+// for UDP or unix:/path for a Unix domain socket on the same machine.
+class NetplaySocket {
+    int socketDescriptor = -1;
+    sockaddr_storage peerAddress {};
+    socklen_t peerAddressLength = 0;
+    std::string boundPath;
+
+    public:
+    NetplaySocket(std::string localAddress, std::string peerAddress);
+    ~NetplaySocket();
+    void send(const std::vector<uint8_t> &packet);
+    bool receive(std::vector<uint8_t> &packet);
+};
@@ -0,0 +1,39 @@
+#include "RomWatcher.h"
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+RomWatcher::RomWatcher(std::string romFilePath) {
+    auto separator = romFilePath.find_last_of('/');
+    auto directory = separator == std::string::npos ? "." : romFilePath.substr(0, separator);
+    fileName = separator == std::string::npos ? romFilePath : romFilePath.substr(separator + 1);
+
+    inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotifyDescriptor < 0) {
+        throw WatchFailedException();
+    }
+    if(inotify_add_watch(inotifyDescriptor, directory.c_str(),
+        IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(inotifyDescriptor);
+        throw WatchFailedException();
+    }
+}
+
+RomWatcher::~RomWatcher() {
+    close(inotifyDescriptor);
+}
+
+bool RomWatcher::hasChanged() {
+    alignas(inotify_event) char buffer[4096];
+    bool changed = false;
+    ssize_t length;
+    while((length = read(inotifyDescriptor, buffer, sizeof(buffer))) > 0) {
+        for(char *position = buffer; position < buffer + length;) {
+            auto event = reinterpret_cast<inotify_event *>(position);
+            if(event->len > 0 && fileName == event->name)
+                changed = true;
+            position += sizeof(inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
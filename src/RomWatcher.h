@@ -0,0 +1,21 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+
+class WatchFailedException: public std::runtime_error {
+    public:
+    WatchFailedException():runtime_error("Could not watch rom file for changes"){}
+};
+
+// Watches the directory holding the rom, so editors that save by writing a
+// new file and renaming it over the old one are noticed too. Only finished
+// writes and renames count; a file that was just created is still empty.
+class RomWatcher {
+    int inotifyDescriptor;
+    std::string fileName;
+
+    public:
+    RomWatcher(std::string romFilePath);
+    ~RomWatcher();
+    bool hasChanged();
+};
@@ -2,8 +2,8 @@
 
 Screen::Screen(int initialWidth, int initialHeight) {
     window = tryToCreateWindow(initialWidth, initialHeight);
-    surface = SDL_GetWindowSurface(window);
-    calculatePixelDimensions(initialWidth, initialHeight);
+    renderer = tryToCreateRenderer();
+    texture = tryToCreateTexture();
 }
 
 SDL_Window *Screen::tryToCreateWindow(int width, int height) {
@@ -21,6 +21,29 @@ SDL_Window *Screen::tryToCreateWindow(int width, int height) {
     return window;
 }
 
+SDL_Renderer *Screen::tryToCreateRenderer() {
+    auto renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    if(renderer == NULL) {
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+    }
+    if(renderer == NULL) {
+        printFailureMessage(SDL_GetError());
+    }
+    return renderer;
+}
+
+SDL_Texture *Screen::tryToCreateTexture() {
+    auto texture = SDL_CreateTexture(renderer,
+        SDL_PIXELFORMAT_ARGB8888,
+        SDL_TEXTUREACCESS_STREAMING,
+        HIRES_WIDTH,
+        HIRES_HEIGHT);
+    if(texture == NULL) {
+        printFailureMessage(SDL_GetError());
+    }
+    return texture;
+}
+
 void Screen::printFailureMessage(const char *message) {
     std::cerr << "SDL window failure. Error: "
         << message
@@ -28,41 +51,48 @@ void Screen::printFailureMessage(const char *message) {
 }
 
 void Screen::update(PixelMatrix pixels) {
-    drawBackground();
-    int y = 0;
-    for(auto row: pixels) {
-        int x = 0;
-        for(auto pixel: row) {
-            if(pixel)
-                drawPixel(x, y);
-            ++x;
+    void *texturePixels;
+    int pitch;
+    if(SDL_LockTexture(texture, NULL, &texturePixels, &pitch) < 0) {
+        printFailureMessage(SDL_GetError());
+        return;
+    }
+    int width = pixels.getWidth();
+    int height = pixels.getHeight();
+    for(int y = 0; y < height; ++y) {
+        auto row = reinterpret_cast<uint32_t *>(
+            static_cast<uint8_t *>(texturePixels) + y * pitch);
+        for(int word = 0; word < width / 64; ++word) {
+            uint64_t low = pixels.planes[0][y][word];
+            uint64_t high = pixels.planes[1][y][word];
+            for(int bit = 63; bit >= 0; --bit) {
+                *row++ = DISPLAY_PALETTE[(low >> bit & 1) | (high >> bit & 1) << 1];
+            }
         }
-        ++y;
     }
+    SDL_UnlockTexture(texture);
 
-    SDL_UpdateWindowSurface(window);
+    // The texture is sized for high resolution; low resolution frames only
+    // fill and scale up its top-left corner
+    SDL_Rect source {0, 0, width, height};
+    SDL_RenderClear(renderer);
+    SDL_RenderCopy(renderer, texture, &source, NULL);
 }
 
-void Screen::drawPixel(int x, int y) {
-    SDL_Rect rect = SDL_Rect();
-    rect.x = x*pixelWidth;
-    rect.y = y*pixelHeight;
-    rect.w = pixelWidth;
-    rect.h = pixelHeight;
-    SDL_FillRect(surface, &rect, SDL_MapRGB(surface->format, 0xFF, 0xFF, 0xFF));
+void Screen::present() {
+    SDL_RenderPresent(renderer);
 }
 
-void Screen::calculatePixelDimensions(int screenWidth, int screenHeight) {
-    pixelWidth = screenWidth / CHIP8_DISPLAY_WIDTH;
-    pixelHeight = screenHeight / CHIP8_DISPLAY_HEIGTH;
+SDL_Window *Screen::getWindow() {
+    return window;
 }
 
-void Screen::drawBackground() {
-    SDL_FillRect(surface,
-        NULL,
-        SDL_MapRGB(surface->format, 0, 0, 0));
+SDL_Renderer *Screen::getRenderer() {
+    return renderer;
 }
 
 Screen::~Screen() {
+    SDL_DestroyTexture(texture);
+    SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
-}
\ No newline at end of file
+}
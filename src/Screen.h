@@ -10,18 +10,19 @@ class Screen {
     #define WINDOW_TITLE "Chip-8 emulator"
 
     SDL_Window *window = nullptr;
-    SDL_Surface *surface = nullptr;
-    int pixelWidth;
-    int pixelHeight;
+    SDL_Renderer *renderer = nullptr;
+    SDL_Texture *texture = nullptr;
 
     void printFailureMessage(const char *message);
     SDL_Window *tryToCreateWindow(int width, int height);
-    void drawBackground();
-    void drawPixel(int x, int y);
-    void calculatePixelDimensions(int screenWidth, int screenHeight);
+    SDL_Renderer *tryToCreateRenderer();
+    SDL_Texture *tryToCreateTexture();
 
     public:
     Screen(int initialWidth, int initialHeight);
     ~Screen();
     void update(PixelMatrix pixels);
-};
\ No newline at end of file
+    void present();
+    SDL_Window *getWindow();
+    SDL_Renderer *getRenderer();
+};
@@ -0,0 +1,72 @@
+#include "SharedStateExport.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+SharedStateExport::SharedStateExport(std::string _name): name(_name) {
+    if(name.empty() || name[0] != '/')
+        name = "/" + name;
+    // Another emulator (or a crashed one) may own the name; never take it over
+    int descriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(descriptor < 0 && errno == EEXIST) {
+        throw SharedStateException("Shared memory " + name + " is already in use, pick another --shm name"
+            " or remove /dev/shm" + name + " if no emulator is running");
+    }
+    if(descriptor < 0) {
+        throw SharedStateException();
+    }
+    bool sized = ftruncate(descriptor, sizeof(SharedStateSegment)) == 0;
+    void *memory = sized
+        ? mmap(nullptr, sizeof(SharedStateSegment), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0)
+        : MAP_FAILED;
+    close(descriptor);
+    if(memory == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw SharedStateException();
+    }
+    segment = new(memory) SharedStateSegment();
+    segment->version = SHARED_STATE_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->magic = SHARED_STATE_MAGIC;
+}
+
+SharedStateExport::~SharedStateExport() {
+    segment->~SharedStateSegment();
+    munmap(segment, sizeof(SharedStateSegment));
+    shm_unlink(name.c_str());
+}
+
+void SharedStateExport::publish(const Chip8 &chip8, const PixelMatrix &pixels, uint16_t keyMask,
+    const std::vector<MemoryWatch> &watches) {
+    ++snapshot.frame;
+    snapshot.cycleCount = chip8.getCycleCount();
+    snapshot.programCounter = chip8.getProgramCounter();
+    snapshot.indexPointer = chip8.getIndexPointer();
+    for(int i = 0; i < 16; ++i)
+        snapshot.variables[i] = chip8.getRegister(i);
+    snapshot.stackDepth = chip8.getStackDepth();
+    snapshot.halted = chip8.isHalted();
+    snapshot.keyMask = keyMask;
+    snapshot.watchCount = std::min<size_t>(watches.size(), SHARED_WATCH_COUNT);
+    for(unsigned int i = 0; i < snapshot.watchCount; ++i) {
+        auto &watch = snapshot.watches[i];
+        memset(watch.name, 0, sizeof(watch.name));
+        strncpy(watch.name, watches[i].name.c_str(), sizeof(watch.name) - 1);
+        watch.location = watches[i].location;
+        watch.value = readLocation(chip8, watches[i].location);
+    }
+    snapshot.display = pixels;
+    writeSharedSnapshot(*segment, snapshot);
+}
+
+void SharedStateExport::applyInput(Chip8Keyboard &keyboard) {
+    while(auto event = segment->input.peek()) {
+        if(event->key <= CHIP8_F)
+            keyboard[event->key] = event->pressed;
+        segment->input.pop();
+    }
+}
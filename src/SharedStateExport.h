@@ -0,0 +1,27 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+#include "core/Chip8.h"
+#include "core/SharedState.h"
+#include "core/MemorySearch.h"
+
+class SharedStateException: public std::runtime_error {
+    public:
+    SharedStateException():runtime_error("Could not create shared memory segment"){}
+    SharedStateException(const std::string &message):runtime_error(message){}
+};
+
+// Owns a POSIX shared memory segment holding the latest frame, registers
+// and keypad of one emulator, plus the ring consumers send key events over.
+class SharedStateExport {
+    std::string name;
+    SharedStateSegment *segment = nullptr;
+    SharedSnapshot snapshot {};
+
+    public:
+    SharedStateExport(std::string name);
+    ~SharedStateExport();
+    void publish(const Chip8 &chip8, const PixelMatrix &pixels, uint16_t keyMask,
+        const std::vector<MemoryWatch> &watches);
+    void applyInput(Chip8Keyboard &keyboard);
+};
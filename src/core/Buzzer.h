@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+#include "SpscRing.h"
+
+constexpr unsigned int BUZZER_RING_CAPACITY = 1024;
+
+struct BuzzerEvent {
+    uint64_t cycle;
+    bool on;
+};
+
+typedef SpscRing<BuzzerEvent, BUZZER_RING_CAPACITY> BuzzerRing;
@@ -0,0 +1,346 @@
+#include "CaptureFormat.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <unordered_map>
+
+namespace {
+
+constexpr unsigned int GIF_MIN_CODE_SIZE = 2;
+constexpr unsigned int GIF_MAX_CODES = 4096;
+constexpr unsigned int PNG_BIT_DEPTH = 2;
+constexpr uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+
+void putU16LE(std::vector<uint8_t> &out, uint16_t value) {
+    out.push_back(value & 0xFF);
+    out.push_back(value >> 8);
+}
+
+void putU16BE(std::vector<uint8_t> &out, uint16_t value) {
+    out.push_back(value >> 8);
+    out.push_back(value & 0xFF);
+}
+
+void putU32BE(std::vector<uint8_t> &out, uint32_t value) {
+    putU16BE(out, value >> 16);
+    putU16BE(out, value & 0xFFFF);
+}
+
+uint8_t red(uint32_t color) {
+    return color >> 16;
+}
+
+uint8_t green(uint32_t color) {
+    return color >> 8;
+}
+
+uint8_t blue(uint32_t color) {
+    return color;
+}
+
+bool endsWith(const std::string &text, const std::string &suffix) {
+    return text.size() >= suffix.size()
+        && std::equal(suffix.rbegin(), suffix.rend(), text.rbegin(),
+            [](char a, char b) { return std::tolower(a) == b; });
+}
+
+// Variable width LZW as GIF uses it, codes packed least significant bit first
+class LzwPacker {
+    std::vector<uint8_t> &out;
+    uint32_t buffer = 0;
+    unsigned int bits = 0;
+
+    public:
+    unsigned int codeSize = GIF_MIN_CODE_SIZE + 1;
+
+    LzwPacker(std::vector<uint8_t> &_out): out(_out) {}
+
+    void emit(uint16_t code) {
+        buffer |= uint32_t(code) << bits;
+        bits += codeSize;
+        while(bits >= 8) {
+            out.push_back(buffer & 0xFF);
+            buffer >>= 8;
+            bits -= 8;
+        }
+    }
+
+    void flush() {
+        if(bits > 0)
+            out.push_back(buffer & 0xFF);
+        buffer = 0;
+        bits = 0;
+    }
+};
+
+void lzwEncode(const std::vector<uint8_t> &indices, std::vector<uint8_t> &out) {
+    const uint16_t clearCode = 1 << GIF_MIN_CODE_SIZE;
+    const uint16_t endCode = clearCode + 1;
+    std::unordered_map<uint32_t, uint16_t> codes;
+    uint16_t nextCode = endCode + 1;
+    LzwPacker packer(out);
+
+    packer.emit(clearCode);
+    uint16_t prefix = indices[0];
+    for(size_t i = 1; i < indices.size(); ++i) {
+        uint32_t key = uint32_t(prefix) << 8 | indices[i];
+        auto code = codes.find(key);
+        if(code != codes.end()) {
+            prefix = code->second;
+            continue;
+        }
+        packer.emit(prefix);
+        if(nextCode < GIF_MAX_CODES) {
+            codes[key] = nextCode;
+            if(nextCode == (1u << packer.codeSize) && packer.codeSize < 12)
+                ++packer.codeSize;
+            ++nextCode;
+        } else {
+            packer.emit(clearCode);
+            codes.clear();
+            nextCode = endCode + 1;
+            packer.codeSize = GIF_MIN_CODE_SIZE + 1;
+        }
+        prefix = indices[i];
+    }
+    packer.emit(prefix);
+    packer.emit(endCode);
+    packer.flush();
+}
+
+uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> entries {};
+        for(uint32_t i = 0; i < 256; ++i) {
+            uint32_t value = i;
+            for(int bit = 0; bit < 8; ++bit)
+                value = value & 1 ? 0xEDB88320 ^ (value >> 1) : value >> 1;
+            entries[i] = value;
+        }
+        return entries;
+    }();
+    crc = ~crc;
+    for(size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// zlib stream made of stored deflate blocks; frames are a few KB, so
+// compressing them is not worth a dependency
+void zlibStore(const std::vector<uint8_t> &data, std::vector<uint8_t> &out) {
+    out.push_back(0x78);
+    out.push_back(0x01);
+    size_t offset = 0;
+    do {
+        uint16_t length = std::min<size_t>(data.size() - offset, 0xFFFF);
+        bool last = offset + length == data.size();
+        out.push_back(last ? 1 : 0);
+        putU16LE(out, length);
+        putU16LE(out, ~length);
+        out.insert(out.end(), data.begin() + offset, data.begin() + offset + length);
+        offset += length;
+    } while(offset < data.size());
+
+    uint32_t a = 1, b = 0;
+    for(auto byte: data) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    putU32BE(out, b << 16 | a);
+}
+
+}
+
+CaptureEncoder::CaptureEncoder(FILE *_file): file(_file) {}
+
+CaptureEncoder::~CaptureEncoder() {
+    fclose(file);
+}
+
+void CaptureEncoder::toColorIndices(const PixelMatrix &pixels) {
+    indices.resize(CAPTURE_WIDTH * CAPTURE_HEIGHT);
+    unsigned int scale = CAPTURE_WIDTH / pixels.getWidth();
+    for(unsigned int y = 0; y < CAPTURE_HEIGHT; ++y) {
+        auto row = &indices[y * CAPTURE_WIDTH];
+        for(unsigned int x = 0; x < CAPTURE_WIDTH; ++x) {
+            row[x] = pixels.getPixel(x / scale, y / scale);
+        }
+    }
+}
+
+std::unique_ptr<CaptureEncoder> CaptureEncoder::open(const std::string &path) {
+    bool gif = endsWith(path, ".gif");
+    bool apng = endsWith(path, ".png") || endsWith(path, ".apng");
+    bool y4m = endsWith(path, ".y4m");
+    if(!gif && !apng && !y4m)
+        throw CaptureFileException("Capture file must end in .gif, .png, .apng or .y4m");
+    auto file = fopen(path.c_str(), "wb");
+    if(file == nullptr)
+        throw CaptureFileException("Could not open capture file for writing");
+    if(gif)
+        return std::make_unique<GifEncoder>(file);
+    if(apng)
+        return std::make_unique<ApngEncoder>(file);
+    return std::make_unique<Y4mEncoder>(file);
+}
+
+GifEncoder::GifEncoder(FILE *file): CaptureEncoder(file) {
+    std::vector<uint8_t> header = {'G', 'I', 'F', '8', '9', 'a'};
+    putU16LE(header, CAPTURE_WIDTH);
+    putU16LE(header, CAPTURE_HEIGHT);
+    // Global color table of 2^(1+1) entries
+    header.push_back(0xF1);
+    header.push_back(0);
+    header.push_back(0);
+    for(auto color: DISPLAY_PALETTE) {
+        header.push_back(red(color));
+        header.push_back(green(color));
+        header.push_back(blue(color));
+    }
+    const char loop[] = "\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00";
+    header.insert(header.end(), loop, loop + sizeof(loop) - 1);
+    fwrite(header.data(), 1, header.size(), file);
+}
+
+// Delays are in centiseconds. Rounding is carried over to later frames and
+// every frame lasts at least 2, since viewers slow down anything shorter.
+void GifEncoder::writeFrame(const CaptureFrame &frame) {
+    elapsedFrames += frame.duration;
+    uint64_t target = (elapsedFrames * 100 + CAPTURE_FRAME_RATE / 2) / CAPTURE_FRAME_RATE;
+    uint16_t delay = std::clamp<int64_t>(int64_t(target - elapsedCentiseconds), 2, 0xFFFF);
+    elapsedCentiseconds += delay;
+
+    block.clear();
+    block.insert(block.end(), {0x21, 0xF9, 0x04, 0x00});
+    putU16LE(block, delay);
+    block.insert(block.end(), {0x00, 0x00});
+    block.push_back(0x2C);
+    putU16LE(block, 0);
+    putU16LE(block, 0);
+    putU16LE(block, CAPTURE_WIDTH);
+    putU16LE(block, CAPTURE_HEIGHT);
+    block.push_back(0);
+    block.push_back(GIF_MIN_CODE_SIZE);
+
+    toColorIndices(frame.pixels);
+    std::vector<uint8_t> compressed;
+    lzwEncode(indices, compressed);
+    for(size_t offset = 0; offset < compressed.size(); offset += 255) {
+        auto length = std::min<size_t>(compressed.size() - offset, 255);
+        block.push_back(length);
+        block.insert(block.end(), compressed.begin() + offset, compressed.begin() + offset + length);
+    }
+    block.push_back(0);
+    fwrite(block.data(), 1, block.size(), file);
+}
+
+void GifEncoder::finish() {
+    fputc(0x3B, file);
+    fflush(file);
+}
+
+ApngEncoder::ApngEncoder(FILE *file): CaptureEncoder(file) {
+    fwrite(PNG_SIGNATURE, 1, sizeof(PNG_SIGNATURE), file);
+    std::vector<uint8_t> header;
+    putU32BE(header, CAPTURE_WIDTH);
+    putU32BE(header, CAPTURE_HEIGHT);
+    header.insert(header.end(), {PNG_BIT_DEPTH, 3, 0, 0, 0});
+    writeChunk("IHDR", header);
+    // The frame count is only known at the end, finish() rewrites this chunk
+    animationControlOffset = ftell(file);
+    writeAnimationControl();
+    std::vector<uint8_t> palette;
+    for(auto color: DISPLAY_PALETTE) {
+        palette.push_back(red(color));
+        palette.push_back(green(color));
+        palette.push_back(blue(color));
+    }
+    writeChunk("PLTE", palette);
+}
+
+void ApngEncoder::writeChunk(const char type[4], const std::vector<uint8_t> &data) {
+    chunk.clear();
+    putU32BE(chunk, data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    putU32BE(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+    fwrite(chunk.data(), 1, chunk.size(), file);
+}
+
+void ApngEncoder::writeAnimationControl() {
+    std::vector<uint8_t> control;
+    putU32BE(control, frameCount);
+    putU32BE(control, 0);
+    writeChunk("acTL", control);
+}
+
+void ApngEncoder::writeFrame(const CaptureFrame &frame) {
+    std::vector<uint8_t> control;
+    putU32BE(control, sequenceNumber++);
+    putU32BE(control, CAPTURE_WIDTH);
+    putU32BE(control, CAPTURE_HEIGHT);
+    putU32BE(control, 0);
+    putU32BE(control, 0);
+    putU16BE(control, std::min<uint32_t>(frame.duration, 0xFFFF));
+    putU16BE(control, CAPTURE_FRAME_RATE);
+    control.push_back(0);
+    control.push_back(0);
+    writeChunk("fcTL", control);
+
+    toColorIndices(frame.pixels);
+    imageData.clear();
+    for(unsigned int y = 0; y < CAPTURE_HEIGHT; ++y) {
+        imageData.push_back(0);
+        for(unsigned int x = 0; x < CAPTURE_WIDTH; x += 4) {
+            auto pixel = &indices[y * CAPTURE_WIDTH + x];
+            imageData.push_back(pixel[0] << 6 | pixel[1] << 4 | pixel[2] << 2 | pixel[3]);
+        }
+    }
+    std::vector<uint8_t> data;
+    if(frameCount > 0)
+        putU32BE(data, sequenceNumber++);
+    zlibStore(imageData, data);
+    writeChunk(frameCount == 0 ? "IDAT" : "fdAT", data);
+    ++frameCount;
+}
+
+void ApngEncoder::finish() {
+    writeChunk("IEND", {});
+    fseek(file, animationControlOffset, SEEK_SET);
+    writeAnimationControl();
+    fflush(file);
+}
+
+Y4mEncoder::Y4mEncoder(FILE *file): CaptureEncoder(file) {
+    fprintf(file, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444\n",
+        CAPTURE_WIDTH, CAPTURE_HEIGHT, CAPTURE_FRAME_RATE);
+}
+
+// Raw video has no frame durations, so deduplicated frames are repeated
+void Y4mEncoder::writeFrame(const CaptureFrame &frame) {
+    const size_t planeSize = CAPTURE_WIDTH * CAPTURE_HEIGHT;
+    uint8_t luma[1 << DISPLAY_PLANES], blueDifference[1 << DISPLAY_PLANES],
+        redDifference[1 << DISPLAY_PLANES];
+    for(unsigned int i = 0; i < (1 << DISPLAY_PLANES); ++i) {
+        auto color = DISPLAY_PALETTE[i];
+        luma[i] = (66 * red(color) + 129 * green(color) + 25 * blue(color) + 128) / 256 + 16;
+        blueDifference[i] = (-38 * red(color) - 74 * green(color) + 112 * blue(color) + 128) / 256 + 128;
+        redDifference[i] = (112 * red(color) - 94 * green(color) - 18 * blue(color) + 128) / 256 + 128;
+    }
+
+    toColorIndices(frame.pixels);
+    planes.resize(3 * planeSize);
+    for(size_t i = 0; i < planeSize; ++i) {
+        planes[i] = luma[indices[i]];
+        planes[planeSize + i] = blueDifference[indices[i]];
+        planes[2 * planeSize + i] = redDifference[indices[i]];
+    }
+    for(uint32_t i = 0; i < frame.duration; ++i) {
+        fputs("FRAME\n", file);
+        fwrite(planes.data(), 1, planes.size(), file);
+    }
+}
+
+void Y4mEncoder::finish() {
+    fflush(file);
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Display.h"
+
+// Captures are always written at the high resolution size, low resolution
+// frames are doubled, so switching modes mid-session keeps one frame size.
+constexpr unsigned int CAPTURE_WIDTH = HIRES_WIDTH;
+constexpr unsigned int CAPTURE_HEIGHT = HIRES_HEIGHT;
+constexpr unsigned int CAPTURE_FRAME_RATE = 60;
+
+class CaptureFileException: public std::runtime_error {
+    public:
+    CaptureFileException(const std::string &message):runtime_error(message){}
+};
+
+struct CaptureFrame {
+    PixelMatrix pixels;
+    // How many 60 Hz frames the picture stays on screen
+    uint32_t duration;
+};
+
+class CaptureEncoder {
+    protected:
+    FILE *file;
+    std::vector<uint8_t> indices;
+
+    void toColorIndices(const PixelMatrix &pixels);
+
+    public:
+    CaptureEncoder(FILE *file);
+    virtual ~CaptureEncoder();
+    virtual void writeFrame(const CaptureFrame &frame) = 0;
+    virtual void finish() = 0;
+
+    // Picks the format from the file extension: .gif, .png/.apng or .y4m
+    static std::unique_ptr<CaptureEncoder> open(const std::string &path);
+};
+
+class GifEncoder: public CaptureEncoder {
+    uint64_t elapsedFrames = 0;
+    uint64_t elapsedCentiseconds = 0;
+    std::vector<uint8_t> block;
+
+    public:
+    GifEncoder(FILE *file);
+    void writeFrame(const CaptureFrame &frame);
+    void finish();
+};
+
+class ApngEncoder: public CaptureEncoder {
+    uint32_t sequenceNumber = 0;
+    uint32_t frameCount = 0;
+    long animationControlOffset = 0;
+    std::vector<uint8_t> chunk;
+    std::vector<uint8_t> imageData;
+
+    void writeChunk(const char type[4], const std::vector<uint8_t> &data);
+    void writeAnimationControl();
+
+    public:
+    ApngEncoder(FILE *file);
+    void writeFrame(const CaptureFrame &frame);
+    void finish();
+};
+
+class Y4mEncoder: public CaptureEncoder {
+    std::vector<uint8_t> planes;
+
+    public:
+    Y4mEncoder(FILE *file);
+    void writeFrame(const CaptureFrame &frame);
+    void finish();
+};
@@ -0,0 +1,54 @@
+#include "CaptureWriter.h"
+#include <chrono>
+
+CaptureWriter::CaptureWriter(std::string path):
+    encoder(CaptureEncoder::open(path)) {
+    worker = std::thread(&CaptureWriter::encoderLoop, this);
+}
+
+CaptureWriter::~CaptureWriter() {
+    while(hasPending && !queue.push(pending)) {
+        std::this_thread::yield();
+    }
+    running = false;
+    worker.join();
+    encoder->finish();
+}
+
+void CaptureWriter::addFrame(const PixelMatrix &pixels) {
+    if(hasPending && pending.pixels == pixels) {
+        ++pending.duration;
+        return;
+    }
+    if(hasPending && !queue.push(pending)) {
+        ++pending.duration;
+        ++heldFrames;
+        return;
+    }
+    pending.pixels = pixels;
+    pending.duration = 1;
+    hasPending = true;
+}
+
+uint64_t CaptureWriter::getHeldFrames() const {
+    return heldFrames;
+}
+
+void CaptureWriter::encoderLoop() {
+    while(running.load()) {
+        if(drainQueue() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    drainQueue();
+}
+
+size_t CaptureWriter::drainQueue() {
+    size_t drained = 0;
+    while(auto frame = queue.peek()) {
+        encoder->writeFrame(*frame);
+        queue.pop();
+        ++drained;
+    }
+    return drained;
+}
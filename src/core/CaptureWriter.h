@@ -0,0 +1,32 @@
+#pragma once
+#include "CaptureFormat.h"
+#include "SpscRing.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+constexpr unsigned int CAPTURE_QUEUE_CAPACITY = 64;
+
+// Hands frames from the emulation thread to an encoder thread. Identical
+// consecutive frames are merged before they are queued. When the encoder
+// falls behind and the queue is full, the previous frame is held longer
+// instead of blocking the caller.
+class CaptureWriter {
+    std::unique_ptr<CaptureEncoder> encoder;
+    SpscRing<CaptureFrame, CAPTURE_QUEUE_CAPACITY> queue;
+    CaptureFrame pending {};
+    bool hasPending = false;
+    uint64_t heldFrames = 0;
+    std::atomic<bool> running {true};
+    std::thread worker;
+
+    void encoderLoop();
+    size_t drainQueue();
+
+    public:
+    CaptureWriter(std::string path);
+    ~CaptureWriter();
+    void addFrame(const PixelMatrix &pixels);
+    uint64_t getHeldFrames() const;
+};
@@ -1,12 +1,40 @@
 #include "Chip8.h"
+#include "Debugger.h"
+#include "Hash.h"
 #include <cstring>
+#include <cstdio>
 #include <algorithm>
 
+const char *describeFault(CHIP8_FAULT fault) {
+    switch(fault) {
+        case CHIP8_FAULT_NONE:
+            return "no fault";
+        case CHIP8_FAULT_INVALID_OPCODE:
+            return "invalid opcode";
+        case CHIP8_FAULT_STACK_OVERFLOW:
+            return "stack overflow";
+        case CHIP8_FAULT_STACK_UNDERFLOW:
+            return "stack underflow";
+        case CHIP8_FAULT_INVALID_KEY:
+            return "invalid key";
+        case CHIP8_FAULT_READ_OUT_OF_BOUNDS:
+            return "read out of bounds";
+        case CHIP8_FAULT_WRITE_OUT_OF_BOUNDS:
+            return "write out of bounds";
+        case CHIP8_FAULT_FETCH_OUT_OF_BOUNDS:
+            return "fetch out of bounds";
+        default:
+            return "unknown fault";
+    }
+}
 
-Chip8::Chip8(const Chip8Keyboard &_keyboard):
+
+Chip8::Chip8(const Chip8Keyboard &_keyboard, size_t memorySize):
+    memory(memorySize),
     programCounter(CHIP8_PROGRAM_BEGINNING_ADDRESS),
     indexPointer(0),
     stack(),
+    stackPointer(0),
     delayTimer(),
     soundTimer(),
     randomEngine(std::chrono::steady_clock::now().time_since_epoch().count()),
@@ -17,29 +45,284 @@ Chip8::Chip8(const Chip8Keyboard &_keyboard):
 }
 
 void Chip8::initializeVariables() {
-    memset(memory, 0, sizeof(memory));
+    std::fill(memory.begin(), memory.end(), 0);
     memset(variables, 0, sizeof(variables));
+    memset(persistentFlags, 0, sizeof(persistentFlags));
 }
 
 void Chip8::loadFont() {
-    memcpy(memory + CHIP8_FONT_BEGINNING_ADDRES, font, CHIP8_FONT_MEMORY_LENGTH);
+    memcpy(memory.data() + CHIP8_FONT_BEGINNING_ADDRES, font, CHIP8_FONT_MEMORY_LENGTH);
+    memcpy(memory.data() + CHIP8_BIG_FONT_BEGINNING_ADDRESS, bigFont, CHIP8_BIG_FONT_MEMORY_LENGTH);
 }
 
-void Chip8::loadRom(std::array<char, CHIP8_MAX_PROGRAM_SIZE> data) {
-    memcpy(memory + CHIP8_PROGRAM_BEGINNING_ADDRESS, data.data(), data.size());
+void Chip8::reset() {
+    initializeVariables();
+    loadFont();
+    programCounter = CHIP8_PROGRAM_BEGINNING_ADDRESS;
+    indexPointer = 0;
+    stackPointer = 0;
+    delayTimer.setValue(0);
+    soundTimer.setValue(0);
+    updateBuzzer();
+    display->setHighResolution(false);
+    display->selectPlanes(1);
+    halted = false;
+}
+
+bool Chip8::loadRom(const std::vector<char> &data) {
+    return loadRom(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+}
+
+bool Chip8::loadRom(const uint8_t *data, size_t size) {
+    if(size > getMaxProgramSize())
+        return false;
+    memcpy(memory.data() + CHIP8_PROGRAM_BEGINNING_ADDRESS, data, size);
+    return true;
+}
+
+size_t Chip8::getMaxProgramSize() const {
+    return memory.size() - CHIP8_PROGRAM_BEGINNING_ADDRESS;
+}
+
+void Chip8::saveState(Chip8State &state) const {
+    state.memory = memory;
+    state.programCounter = programCounter;
+    state.indexPointer = indexPointer;
+    state.stack = stack;
+    state.stackPointer = stackPointer;
+    memcpy(state.variables, variables, sizeof(variables));
+    state.delayTimer = delayTimer.getValue();
+    state.soundTimer = soundTimer.getValue();
+    memcpy(state.persistentFlags, persistentFlags, sizeof(persistentFlags));
+    state.randomEngine = randomEngine;
+    state.display = display->getData();
+    state.selectedPlanes = display->getSelectedPlanes();
+    state.halted = halted;
+    state.cycleCount = cycleCount;
+}
+
+void Chip8::restoreState(const Chip8State &state) {
+    memory = state.memory;
+    programCounter = state.programCounter;
+    indexPointer = state.indexPointer;
+    stack = state.stack;
+    stackPointer = state.stackPointer;
+    memcpy(variables, state.variables, sizeof(variables));
+    delayTimer.setValue(state.delayTimer);
+    soundTimer.setValue(state.soundTimer);
+    memcpy(persistentFlags, state.persistentFlags, sizeof(persistentFlags));
+    randomEngine = state.randomEngine;
+    display->setData(state.display);
+    display->selectPlanes(state.selectedPlanes);
+    halted = state.halted;
+    cycleCount = state.cycleCount;
+    // Buzzer events are stamped with the restored cycle count
+    updateBuzzer();
 }
 
 void Chip8::doNextCycle() {
+    if(halted)
+        return;
+    instructionAddress = programCounter;
+    currentOpcode = 0;
     auto instruction = fetchInstruction();
+    if(halted)
+        return;
+    currentOpcode = instruction;
     programCounter = programCounter + 2;
+    ++cycleCount;
+    if(tracer != nullptr) {
+        executeTraced(instruction);
+        return;
+    }
+    execute(instruction);
+}
+
+void Chip8::executeTraced(uint16_t instruction) {
+    TraceRecord record;
+    record.programCounter = programCounter - 2;
+    record.opcode = instruction;
+    uint8_t previousVariables[16];
+    memcpy(previousVariables, variables, sizeof(variables));
+
     execute(instruction);
+
+    record.indexPointer = indexPointer;
+    record.changedRegisters = 0;
+    for(int i = 0; i < 16; ++i) {
+        if(variables[i] != previousVariables[i])
+            record.changedRegisters |= 1 << i;
+    }
+    memcpy(record.variables, variables, sizeof(variables));
+    tracer->push(record);
+}
+
+Chip8RunStatus Chip8::run(unsigned int instructions) {
+    Chip8RunStatus status;
+    auto trapsBefore = trapCount;
+    while(status.executed < instructions && !halted) {
+        doNextCycle();
+        ++status.executed;
+    }
+    status.halted = halted;
+    if(trapCount != trapsBefore)
+        status.trap = lastTrap;
+    return status;
+}
+
+// Runs until the frame's cycle budget is spent; the instruction that crosses
+// it still completes. With the display wait quirk a sprite draw ends the
+// frame early, leaving the rest of the budget unused.
+Chip8RunStatus Chip8::runBudget(uint32_t cycles) {
+    Chip8RunStatus status;
+    auto trapsBefore = trapCount;
+    while(status.cycles < cycles && !halted) {
+        doNextCycle();
+        ++status.executed;
+        status.cycles += getInstructionCycles(currentOpcode);
+        if(waitsForDisplay(currentOpcode))
+            break;
+    }
+    status.halted = halted;
+    if(trapCount != trapsBefore)
+        status.trap = lastTrap;
+    return status;
+}
+
+const Chip8Timing &Chip8::getTiming() const {
+    return timing;
+}
+
+uint32_t Chip8::getInstructionCycles(uint16_t) const {
+    return 1;
+}
+
+bool Chip8::waitsForDisplay(uint16_t instruction) const {
+    return timing.displayWait && (instruction & 0xF000) == 0xD000;
+}
+
+void Chip8::raiseTrap(CHIP8_FAULT fault) {
+    lastTrap = {fault, instructionAddress, currentOpcode};
+    ++trapCount;
+    switch(trapPolicies[fault]) {
+        case CHIP8_TRAP_HALT:
+            halted = true;
+            break;
+        case CHIP8_TRAP_LOG:
+            fprintf(stderr, "Trap: %s at %03X (%04X)\n",
+                describeFault(fault), instructionAddress, currentOpcode);
+            break;
+        case CHIP8_TRAP_SKIP:
+            break;
+    }
+}
+
+void Chip8::setTrapPolicy(CHIP8_TRAP_POLICY policy) {
+    trapPolicies.fill(policy);
+}
+
+void Chip8::setTrapPolicy(CHIP8_FAULT fault, CHIP8_TRAP_POLICY policy) {
+    trapPolicies[fault] = policy;
+}
+
+bool Chip8::isHalted() const {
+    return halted;
+}
+
+const Chip8Trap &Chip8::getLastTrap() const {
+    return lastTrap;
+}
+
+uint64_t Chip8::getTrapCount() const {
+    return trapCount;
+}
+
+void Chip8::tickTimers() {
+    delayTimer.tick();
+    soundTimer.tick();
+    updateBuzzer();
+}
+
+void Chip8::seedRandom(uint32_t seed) {
+    randomEngine.seed(seed);
+}
+
+void Chip8::setTracer(TraceRing *ring) {
+    tracer = ring;
+}
+
+// A newly attached ring learns the current state, which may have changed
+// while no ring was listening.
+void Chip8::setBuzzer(BuzzerRing *ring) {
+    buzzer = ring;
+    if(buzzer != nullptr)
+        buzzer->push({cycleCount, buzzerOn});
+}
+
+uint64_t Chip8::getCycleCount() const {
+    return cycleCount;
+}
+
+void Chip8::setDebugger(Debugger *_debugger) {
+    debugger = _debugger;
+}
+
+void Chip8::setWatchedPages(const Chip8PageSet &readPages, const Chip8PageSet &writePages) {
+    watchedReadPages = readPages;
+    watchedWritePages = writePages;
+}
+
+void Chip8::reportMemoryAccess(uint16_t address, bool write) {
+    if(debugger != nullptr)
+        debugger->onMemoryAccess(address, write);
+}
+
+uint16_t Chip8::getProgramCounter() const {
+    return programCounter;
+}
+
+uint16_t Chip8::getCurrentOpcode() const {
+    return currentOpcode;
+}
+
+uint16_t Chip8::getIndexPointer() const {
+    return indexPointer;
+}
+
+uint8_t Chip8::getRegister(int idx) const {
+    return variables[idx];
+}
+
+uint8_t Chip8::peekMemory(uint16_t address) const {
+    return memory[address % memory.size()];
+}
+
+size_t Chip8::getMemorySize() const {
+    return memory.size();
+}
+
+const std::vector<uint8_t> &Chip8::getMemory() const {
+    return memory;
+}
+
+std::vector<uint16_t> Chip8::getStack() const {
+    return std::vector<uint16_t>(stack.begin(), stack.begin() + stackPointer);
+}
+
+unsigned int Chip8::getStackDepth() const {
+    return stackPointer;
+}
+
+uint64_t Chip8::hashMemory() const {
+    return fnv1a(memory.data(), memory.size());
 }
 
 void Chip8::execute(uint16_t instruction) {
     int handlerIdx = getHandlerIdx(instruction);
 
     if(handlers[handlerIdx] == nullptr) {
-        throw InstructionNotImplemented(instruction);
+        raiseTrap(CHIP8_FAULT_INVALID_OPCODE);
+        return;
     }
 
     (this->*handlers[handlerIdx])(instruction);
@@ -50,6 +333,13 @@ PixelMatrix Chip8::peek() {
 }
 
 uint16_t Chip8::fetchInstruction () {
+    if(programCounter + 1u >= memory.size()) {
+        // Nothing was fetched, so there is nothing to skip; halt whatever
+        // the policy rather than run past the end of memory
+        raiseTrap(CHIP8_FAULT_FETCH_OUT_OF_BOUNDS);
+        halted = true;
+        return 0;
+    }
     uint8_t firstPart = memory[programCounter];
     uint8_t secondPart = memory[programCounter + 1];
     return ((uint16_t) firstPart << 8) | secondPart;
@@ -68,8 +358,11 @@ void Chip8::clearScreen() {
 }
 
 void Chip8::returnFromSubroutine() {
-    programCounter = stack.top();
-    stack.pop();
+    if(stackPointer == 0) {
+        raiseTrap(CHIP8_FAULT_STACK_UNDERFLOW);
+        return;
+    }
+    programCounter = stack[--stackPointer];
 }
 
 void Chip8::jump(uint16_t instruction) {
@@ -79,7 +372,11 @@ void Chip8::jump(uint16_t instruction) {
 
 void Chip8::callASubroutine(uint16_t instruction) {
     uint16_t address = instruction & 0x0FFF;
-    stack.push(programCounter);
+    if(stackPointer == CHIP8_STACK_SIZE) {
+        raiseTrap(CHIP8_FAULT_STACK_OVERFLOW);
+        return;
+    }
+    stack[stackPointer++] = programCounter;
     programCounter = address;
 }
 
@@ -87,7 +384,7 @@ void Chip8::skipEqualLiteral(uint16_t instruction) {
     auto vx = getXRegister(instruction);
     uint8_t val = instruction & 0x00FF;
     if(val == vx)
-        programCounter += 2;
+        skipNextInstruction();
 }
 
 void Chip8::skipEqualRegisters(uint16_t instruction) {
@@ -95,7 +392,7 @@ void Chip8::skipEqualRegisters(uint16_t instruction) {
     auto vy = getYRegister(instruction);
 
     if (vx == vy) {
-        programCounter += 2;
+        skipNextInstruction();
     }
 }
 
@@ -103,7 +400,11 @@ void Chip8::skipNotEqualLietral(uint16_t instruction) {
     auto vx = getXRegister(instruction);
     uint8_t val = instruction & 0x00FF;
     if(val != vx)
-        programCounter += 2;
+        skipNextInstruction();
+}
+
+void Chip8::skipNextInstruction() {
+    programCounter += 2;
 }
 
 void Chip8::setXRegisterToNN(uint16_t instruction) {
@@ -120,7 +421,7 @@ void Chip8::skipNotEqualRegisters(uint16_t instruction) {
     auto vx = getXRegister(instruction);
     auto vy = getYRegister(instruction);
     if(vx != vy) {
-        programCounter += 2;
+        skipNextInstruction();
     }
 }
 
@@ -156,7 +457,7 @@ void Chip8::eightCategoryHandler(uint16_t instruction) {
             shiftLeft(instruction);
             break;
         default:
-            throw InstructionNotImplemented(instruction);
+            raiseTrap(CHIP8_FAULT_INVALID_OPCODE);
             break;
     }
 }
@@ -167,14 +468,14 @@ void Chip8::setIndex(uint16_t instruction) {
 }
 
 void Chip8::getRandomNumber(uint16_t instruction) {
-    int randomNumber = randomEngine() % 0xFF;
+    int randomNumber = randomEngine() & 0xFF;
     int valueToBinaryAnd = instruction & 0x00FF;
     setXRegister(instruction, randomNumber & valueToBinaryAnd);
 }
 
 void Chip8::draw(uint16_t instruction) {
-    int vx = getXRegister(instruction) % CHIP8_DISPLAY_WIDTH;
-    int vy = getYRegister(instruction) % CHIP8_DISPLAY_HEIGTH;
+    int vx = getXRegister(instruction) % display->getWidth();
+    int vy = getYRegister(instruction) % display->getHeight();
     int height = instruction & 0x000F;
     variables[0xF] = display->drawSprite(vx, vy, loadSprite(height));
 }
@@ -188,20 +489,31 @@ void Chip8::eCategoryHandler(uint16_t instruction) {
         case 0xA1:
             skipIfNotHeld(instruction);
             break;
+        default:
+            raiseTrap(CHIP8_FAULT_INVALID_OPCODE);
+            break;
     }
 }
 
 void Chip8::skipIfHeld(uint16_t instruction) {
     auto vx = getXRegister(instruction);
-    if(keyboard.at((CHIP8_KEY)vx)) {
-        programCounter += 2;
+    if(vx > CHIP8_F) {
+        raiseTrap(CHIP8_FAULT_INVALID_KEY);
+        return;
+    }
+    if(keyboard[vx]) {
+        skipNextInstruction();
     }
 }
 
 void Chip8::skipIfNotHeld(uint16_t instruction) {
     auto vx = getXRegister(instruction);
-    if(!keyboard.at((CHIP8_KEY)vx)) {
-        programCounter += 2;
+    if(vx > CHIP8_F) {
+        raiseTrap(CHIP8_FAULT_INVALID_KEY);
+        return;
+    }
+    if(!keyboard[vx]) {
+        skipNextInstruction();
     }
 }
 
@@ -237,27 +549,31 @@ void Chip8::fCategoryHandler(uint16_t instruction) {
             loadRegistersFromMemory(instruction);
             break;
         default:
-            throw InstructionNotImplemented(instruction);
+            raiseTrap(CHIP8_FAULT_INVALID_OPCODE);
             break;
     }
 }
 
 void Chip8::setVxToDelayTimer(uint16_t instruction) {
-    std::chrono::duration<float> timeLeftInSeconds
-        = delayTimer.getStatus();
-    setXRegister(instruction, timeLeftInSeconds.count() * 60);
+    setXRegister(instruction, delayTimer.getValue());
 }
 
 void Chip8::setDelayTimer(uint16_t instruction) {
-    auto vx = getXRegister(instruction); 
-    delayTimer.setTime(std::chrono::milliseconds((vx) * 1000 / 60));
-    delayTimer.startTimer();
+    delayTimer.setValue(getXRegister(instruction));
 }
 
 void Chip8::setSoundTimer(uint16_t instruction) {
-    auto vx = getXRegister(instruction); 
-    soundTimer.setTime(std::chrono::milliseconds((vx) * 1000 / 60));
-    delayTimer.startTimer();
+    soundTimer.setValue(getXRegister(instruction));
+    updateBuzzer();
+}
+
+void Chip8::updateBuzzer() {
+    bool on = !soundTimer.hasFinished();
+    if(on == buzzerOn)
+        return;
+    buzzerOn = on;
+    if(buzzer != nullptr)
+        buzzer->push({cycleCount, on});
 }
 
 void Chip8::addToIndex(uint16_t instruction) {
@@ -269,9 +585,9 @@ void Chip8::addToIndex(uint16_t instruction) {
 }
 
 void Chip8::getKey(uint16_t instruction) {
-    for(auto pair: keyboard) {
-        if(pair.second == true) {
-            setXRegister(instruction, pair.first);
+    for(uint8_t key = CHIP8_0; key <= CHIP8_F; ++key) {
+        if(keyboard[key]) {
+            setXRegister(instruction, key);
             return;
         }
     }
@@ -285,15 +601,15 @@ void Chip8::getFontCharacter(uint16_t instruction) {
 
 void Chip8::binaryCodedDecimalConversion(uint16_t instruction) {
     auto vx = getXRegister(instruction);
-    memory[indexPointer] = vx / 100;
-    memory[indexPointer + 1] = (vx / 10) % 10;
-    memory[indexPointer + 2] = vx % 10;
+    writeMemory(indexPointer, vx / 100);
+    writeMemory(indexPointer + 1, (vx / 10) % 10);
+    writeMemory(indexPointer + 2, vx % 10);
 }
 
 std::vector<uint8_t> Chip8::loadSprite(int height) {
     std::vector<uint8_t> sprite;
     for(int i = 0; i < height; ++i) {
-        sprite.push_back(memory[indexPointer + i]);
+        sprite.push_back(readMemory(indexPointer + i));
     }
     return sprite;
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <cstdint>
-#include <stack>
+#include <array>
+#include <bitset>
 #include <vector>
 #include "Display.h"
 #include <memory>
@@ -8,6 +9,8 @@
 #include <random>
 #include <chrono>
 #include "Timer.h"
+#include "TraceWriter.h"
+#include "Buzzer.h"
 #include <unordered_map>
 
 constexpr unsigned int CHIP8_DISPLAY_WIDTH = 64;
@@ -16,9 +19,20 @@ constexpr unsigned int CHIP8_PROGRAM_BEGINNING_ADDRESS = 0x200;
 constexpr unsigned int CHIP8_TIMER_FREQUENCY = 60;
 constexpr unsigned int CHIP8_FONT_MEMORY_LENGTH = 80;
 constexpr unsigned int CHIP8_FONT_BEGINNING_ADDRES = 0x50;
+constexpr unsigned int CHIP8_BIG_FONT_MEMORY_LENGTH = 160;
+constexpr unsigned int CHIP8_BIG_FONT_BEGINNING_ADDRESS = 0xA0;
+constexpr unsigned int CHIP8_PERSISTENT_FLAGS_COUNT = 16;
 constexpr unsigned int CHIP8_MEMORY_SIZE = 4096;
 constexpr unsigned int CHIP8_MAX_PROGRAM_SIZE = 
     CHIP8_MEMORY_SIZE - CHIP8_PROGRAM_BEGINNING_ADDRESS;
+constexpr unsigned int XOCHIP_MEMORY_SIZE = 65536;
+constexpr unsigned int XOCHIP_MAX_PROGRAM_SIZE =
+    XOCHIP_MEMORY_SIZE - CHIP8_PROGRAM_BEGINNING_ADDRESS;
+constexpr unsigned int CHIP8_STACK_SIZE = 16;
+// Watchpoints are looked up per 256 byte page of the largest memory
+constexpr unsigned int CHIP8_WATCH_PAGE_COUNT = XOCHIP_MEMORY_SIZE >> 8;
+
+typedef std::bitset<CHIP8_WATCH_PAGE_COUNT> Chip8PageSet;
 
 enum CHIP8_KEY {
     CHIP8_0,
@@ -39,39 +53,127 @@ enum CHIP8_KEY {
     CHIP8_F
 };
 
-class InstructionNotImplemented : public std::runtime_error {
-    uint16_t opcode;
-    public:
-        InstructionNotImplemented(uint16_t opcode): runtime_error("Instruction has not been yet implemented") {
-            this->opcode = opcode;
-        }
-        uint16_t getOpcode() {
-            return opcode;
-        }
+enum CHIP8_FAULT {
+    CHIP8_FAULT_NONE,
+    CHIP8_FAULT_INVALID_OPCODE,
+    CHIP8_FAULT_STACK_OVERFLOW,
+    CHIP8_FAULT_STACK_UNDERFLOW,
+    CHIP8_FAULT_INVALID_KEY,
+    CHIP8_FAULT_READ_OUT_OF_BOUNDS,
+    CHIP8_FAULT_WRITE_OUT_OF_BOUNDS,
+    CHIP8_FAULT_FETCH_OUT_OF_BOUNDS,
+    CHIP8_FAULT_COUNT
+};
+
+// What the core does after recording a trap. The faulting access itself is
+// always dropped; skip and log carry on with the next instruction. A fetch
+// out of bounds halts under every policy.
+enum CHIP8_TRAP_POLICY {
+    CHIP8_TRAP_HALT,
+    CHIP8_TRAP_SKIP,
+    CHIP8_TRAP_LOG
+};
+
+struct Chip8Trap {
+    CHIP8_FAULT fault = CHIP8_FAULT_NONE;
+    uint16_t programCounter = 0;
+    uint16_t opcode = 0;
+};
+
+struct Chip8RunStatus {
+    unsigned int executed = 0;
+    // Cycles spent, counted by runBudget only
+    uint32_t cycles = 0;
+    bool halted = false;
+    // Last trap raised during the run, if any
+    Chip8Trap trap;
+};
+
+// How an implementation spends a 60 Hz frame. Instruction costs are in the
+// machine's own cycles; a zero budget means there is no timing model and
+// frames run a fixed number of instructions instead.
+struct Chip8Timing {
+    uint32_t cyclesPerFrame = 0;
+    // A sprite draw waits for the next vertical blank, ending the frame
+    bool displayWait = false;
+};
+
+const char *describeFault(CHIP8_FAULT fault);
+
+typedef std::array<bool, 16> Chip8Keyboard;
+
+inline uint16_t toKeyMask(const Chip8Keyboard &keyboard) {
+    uint16_t mask = 0;
+    for(int key = CHIP8_0; key <= CHIP8_F; ++key)
+        mask |= keyboard[key] << key;
+    return mask;
+}
+
+inline void applyKeyMask(Chip8Keyboard &keyboard, uint16_t mask) {
+    for(int key = CHIP8_0; key <= CHIP8_F; ++key)
+        keyboard[key] = mask & (1 << key);
+}
+typedef std::minstd_rand Chip8RandomEngine;
+
+struct Chip8State {
+    std::vector<uint8_t> memory;
+    uint16_t programCounter;
+    uint16_t indexPointer;
+    std::array<uint16_t, CHIP8_STACK_SIZE> stack;
+    uint8_t stackPointer;
+    uint8_t variables[16];
+    uint8_t delayTimer;
+    uint8_t soundTimer;
+    uint8_t persistentFlags[CHIP8_PERSISTENT_FLAGS_COUNT];
+    Chip8RandomEngine randomEngine;
+    PixelMatrix display;
+    uint8_t selectedPlanes;
+    bool halted;
+    uint64_t cycleCount;
 };
 
-typedef std::unordered_map<CHIP8_KEY, bool> Chip8Keyboard;
+class Debugger;
 
 class Chip8 {
 
     protected:
-    uint8_t memory[CHIP8_MEMORY_SIZE];
+    std::vector<uint8_t> memory;
     uint16_t programCounter;
     uint16_t indexPointer;
-    std::stack<uint16_t> stack;
+    std::array<uint16_t, CHIP8_STACK_SIZE> stack;
+    uint8_t stackPointer;
     uint8_t variables[16];
+    uint8_t persistentFlags[CHIP8_PERSISTENT_FLAGS_COUNT];
 
     Timer delayTimer;
     Timer soundTimer;
 
     const Chip8Keyboard &keyboard;
 
-    std::mt19937 randomEngine;
+    Chip8RandomEngine randomEngine;
 
     typedef void(Chip8::*InstructionHandler)(uint16_t);
 
     std::unique_ptr<Display> display;
 
+    TraceRing *tracer = nullptr;
+
+    BuzzerRing *buzzer = nullptr;
+    bool buzzerOn = false;
+    uint64_t cycleCount = 0;
+
+    Debugger *debugger = nullptr;
+    Chip8PageSet watchedReadPages;
+    Chip8PageSet watchedWritePages;
+
+    std::array<CHIP8_TRAP_POLICY, CHIP8_FAULT_COUNT> trapPolicies {};
+    Chip8Trap lastTrap;
+    uint64_t trapCount = 0;
+    bool halted = false;
+    uint16_t instructionAddress = 0;
+    uint16_t currentOpcode = 0;
+    Chip8Timing timing;
+
     uint8_t font[CHIP8_FONT_MEMORY_LENGTH] = {
         0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
         0x20, 0x60, 0x20, 0x20, 0x70, // 1
@@ -91,10 +193,31 @@ class Chip8 {
         0xF0, 0x80, 0xF0, 0x80, 0x80  // F
     };
 
+    uint8_t bigFont[CHIP8_BIG_FONT_MEMORY_LENGTH] = {
+        0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C, // 0
+        0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, // 1
+        0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF, // 2
+        0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C, // 3
+        0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06, // 4
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C, // 5
+        0x3E, 0x7C, 0xE0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C, // 6
+        0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60, // 7
+        0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C, // 8
+        0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C, // 9
+        0x18, 0x3C, 0x66, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+        0xFC, 0xFE, 0xC3, 0xC3, 0xFE, 0xFE, 0xC3, 0xC3, 0xFE, 0xFC, // B
+        0x3C, 0x7E, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0x7E, 0x3C, // C
+        0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFC, 0xC0, 0xC0, 0xFF, 0xFF, // E
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFC, 0xC0, 0xC0, 0xC0, 0xC0  // F
+    };
+
     void initializeVariables();
     void loadFont();
     uint16_t fetchInstruction();
     void execute(uint16_t instruction);
+    void executeTraced(uint16_t instruction);
+    void updateBuzzer();
     int getXIdx(uint16_t instruction);
     int getYIdx(uint16_t instruction);
     uint8_t getXRegister(uint16_t instruction);
@@ -103,13 +226,18 @@ class Chip8 {
     void setYRegister(uint16_t instruction, uint8_t newValue);
     int getHandlerIdx(uint16_t instruction);
     std::vector<uint8_t> loadSprite(int height);
+    uint8_t readMemory(uint16_t address);
+    void writeMemory(uint16_t address, uint8_t value);
+    void reportMemoryAccess(uint16_t address, bool write);
+    void raiseTrap(CHIP8_FAULT fault);
+    virtual void skipNextInstruction();
 
-    void zeroCategoryHandler(uint16_t instruction);
+    virtual void zeroCategoryHandler(uint16_t instruction);
     void jump(uint16_t instruction);
     void callASubroutine(uint16_t instruction);
     void skipEqualLiteral(uint16_t instruction);
     void skipNotEqualLietral(uint16_t instruction);
-    void skipEqualRegisters(uint16_t instruction);
+    virtual void skipEqualRegisters(uint16_t instruction);
     void skipNotEqualRegisters(uint16_t instruction);
     void eightCategoryHandler(uint16_t instruction);
     void setXRegisterToNN(uint16_t instruction);
@@ -117,9 +245,9 @@ class Chip8 {
     void setIndex(uint16_t instruction);
     virtual void jumpWithOffset(uint16_t instruction) = 0;
     void getRandomNumber(uint16_t instruction);
-    void draw(uint16_t instruction);
+    virtual void draw(uint16_t instruction);
     void eCategoryHandler(uint16_t instruction);
-    void fCategoryHandler(uint16_t instruction);
+    virtual void fCategoryHandler(uint16_t instruction);
 
     void clearScreen();
     void returnFromSubroutine();
@@ -167,8 +295,62 @@ class Chip8 {
     };
 
     public:
-        Chip8(const Chip8Keyboard &keyboard);
+        Chip8(const Chip8Keyboard &keyboard, size_t memorySize = CHIP8_MEMORY_SIZE);
+        virtual ~Chip8() = default;
         void doNextCycle();
-        void loadRom(std::array<char, CHIP8_MAX_PROGRAM_SIZE> data);
+        Chip8RunStatus run(unsigned int instructions);
+        Chip8RunStatus runBudget(uint32_t cycles);
+        const Chip8Timing &getTiming() const;
+        virtual uint32_t getInstructionCycles(uint16_t instruction) const;
+        bool waitsForDisplay(uint16_t instruction) const;
+        void setTrapPolicy(CHIP8_TRAP_POLICY policy);
+        void setTrapPolicy(CHIP8_FAULT fault, CHIP8_TRAP_POLICY policy);
+        bool isHalted() const;
+        const Chip8Trap &getLastTrap() const;
+        uint64_t getTrapCount() const;
+        void tickTimers();
+        void seedRandom(uint32_t seed);
+        void reset();
+        // False, with nothing loaded, when the rom does not fit in memory
+        bool loadRom(const std::vector<char> &data);
+        bool loadRom(const uint8_t *data, size_t size);
+        size_t getMaxProgramSize() const;
+        void saveState(Chip8State &state) const;
+        void restoreState(const Chip8State &state);
         PixelMatrix peek();
-};
\ No newline at end of file
+        void setTracer(TraceRing *ring);
+        void setBuzzer(BuzzerRing *ring);
+        uint64_t getCycleCount() const;
+        void setDebugger(Debugger *debugger);
+        void setWatchedPages(const Chip8PageSet &readPages, const Chip8PageSet &writePages);
+        uint16_t getProgramCounter() const;
+        uint16_t getCurrentOpcode() const;
+        uint16_t getIndexPointer() const;
+        uint8_t getRegister(int idx) const;
+        uint8_t peekMemory(uint16_t address) const;
+        size_t getMemorySize() const;
+        const std::vector<uint8_t> &getMemory() const;
+        std::vector<uint16_t> getStack() const;
+        unsigned int getStackDepth() const;
+        uint64_t hashMemory() const;
+};
+
+inline uint8_t Chip8::readMemory(uint16_t address) {
+    if(watchedReadPages[address >> 8])
+        reportMemoryAccess(address, false);
+    if(address >= memory.size()) {
+        raiseTrap(CHIP8_FAULT_READ_OUT_OF_BOUNDS);
+        return 0;
+    }
+    return memory[address];
+}
+
+inline void Chip8::writeMemory(uint16_t address, uint8_t value) {
+    if(watchedWritePages[address >> 8])
+        reportMemoryAccess(address, true);
+    if(address >= memory.size()) {
+        raiseTrap(CHIP8_FAULT_WRITE_OUT_OF_BOUNDS);
+        return;
+    }
+    memory[address] = value;
+}
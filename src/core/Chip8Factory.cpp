@@ -5,7 +5,34 @@ std::unique_ptr<Chip8> Chip8Factory::make(CHIP8_IMPLEMENTATION impl,
     switch(impl) {
         case SCHIP:
             return std::unique_ptr<Chip8>(new SChip(keyboard));
+        case XOCHIP:
+            return std::unique_ptr<Chip8>(new XOChip(keyboard));
         default:
             return std::unique_ptr<Chip8>(new OriginalChip8(keyboard));
     }
-}
\ No newline at end of file
+}
+
+std::optional<CHIP8_IMPLEMENTATION> Chip8Factory::fromName(const std::string &name) {
+    if(name == "default" || name == "original")
+        return ORIGINAL_CHIP8;
+    if(name == "schip")
+        return SCHIP;
+    if(name == "xochip")
+        return XOCHIP;
+    return std::nullopt;
+}
+
+const char *Chip8Factory::toName(CHIP8_IMPLEMENTATION impl) {
+    switch(impl) {
+        case SCHIP:
+            return "schip";
+        case XOCHIP:
+            return "xochip";
+        default:
+            return "default";
+    }
+}
+
+size_t Chip8Factory::getMaxProgramSize(CHIP8_IMPLEMENTATION impl) {
+    return impl == XOCHIP ? XOCHIP_MAX_PROGRAM_SIZE : CHIP8_MAX_PROGRAM_SIZE;
+}
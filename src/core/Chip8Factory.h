@@ -2,11 +2,15 @@
 #include "Chip8.h"
 #include "SChip.h"
 #include "OriginalChip8.h"
+#include "XOChip.h"
 #include <memory>
+#include <optional>
+#include <string>
 
 enum CHIP8_IMPLEMENTATION {
     ORIGINAL_CHIP8,
-    SCHIP
+    SCHIP,
+    XOCHIP
 };
 
 class Chip8Factory {
@@ -14,4 +18,7 @@ class Chip8Factory {
 
     static std::unique_ptr<Chip8> make(CHIP8_IMPLEMENTATION impl,
         const Chip8Keyboard &keyboard);
+    static std::optional<CHIP8_IMPLEMENTATION> fromName(const std::string &name);
+    static const char *toName(CHIP8_IMPLEMENTATION impl);
+    static size_t getMaxProgramSize(CHIP8_IMPLEMENTATION impl);
 };
\ No newline at end of file
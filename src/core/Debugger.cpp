@@ -0,0 +1,201 @@
+#include "Debugger.h"
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+Debugger::Debugger(Chip8 &_chip8): chip8(_chip8) {
+    chip8.setDebugger(this);
+}
+
+Debugger::~Debugger() {
+    chip8.setWatchedPages(Chip8PageSet(), Chip8PageSet());
+    chip8.setDebugger(nullptr);
+}
+
+bool Debugger::isArmed() const {
+    return paused || pendingSteps > 0 || !breakpoints.empty() || !watchpoints.empty();
+}
+
+bool Debugger::isPaused() const {
+    return paused && pendingSteps == 0;
+}
+
+int Debugger::runCycles(int cycles) {
+    uint32_t cyclesSpent = 0;
+    return run(cycles, 0, cyclesSpent);
+}
+
+int Debugger::runBudget(uint32_t cycleBudget, uint32_t &cyclesSpent) {
+    return run(std::numeric_limits<int>::max(), cycleBudget, cyclesSpent);
+}
+
+// A zero cycleBudget leaves only the instruction limit
+int Debugger::run(int instructions, uint32_t cycleBudget, uint32_t &cyclesSpent) {
+    int executed = 0;
+    cyclesSpent = 0;
+    while(executed < instructions && !chip8.isHalted()) {
+        if(cycleBudget > 0 && cyclesSpent >= cycleBudget)
+            break;
+        if(paused && pendingSteps == 0)
+            break;
+        auto programCounter = chip8.getProgramCounter();
+        if(!skipBreakpointOnce && pendingSteps == 0 && hitsBreakpoint(programCounter)) {
+            char message[64];
+            snprintf(message, sizeof(message), "Breakpoint hit at %03X", programCounter);
+            stop(message);
+            break;
+        }
+        skipBreakpointOnce = false;
+        auto trapsBefore = chip8.getTrapCount();
+        chip8.doNextCycle();
+        if(chip8.getTrapCount() != trapsBefore) {
+            auto &trap = chip8.getLastTrap();
+            char message[64];
+            snprintf(message, sizeof(message), "Trap: %s at %03X (%04X)",
+                describeFault(trap.fault), trap.programCounter, trap.opcode);
+            stop(message);
+        }
+        ++executed;
+        bool waitsForDisplay = false;
+        if(cycleBudget > 0) {
+            auto opcode = chip8.getCurrentOpcode();
+            cyclesSpent += chip8.getInstructionCycles(opcode);
+            waitsForDisplay = chip8.waitsForDisplay(opcode);
+        }
+        if(pendingSteps > 0 && --pendingSteps == 0 && !stopMessage) {
+            char message[64];
+            snprintf(message, sizeof(message), "Stepped to %03X", chip8.getProgramCounter());
+            stop(message);
+        }
+        if(waitsForDisplay)
+            break;
+    }
+    return executed;
+}
+
+bool Debugger::hitsBreakpoint(uint16_t programCounter) const {
+    bool addressHit = programCounter < XOCHIP_MEMORY_SIZE && addressBreakpoints[programCounter];
+    if(!addressHit && !hasAddresslessBreakpoints)
+        return false;
+    for(auto &breakpoint: breakpoints) {
+        if(breakpoint.address && breakpoint.address != programCounter)
+            continue;
+        if(!breakpoint.condition || evaluate(*breakpoint.condition))
+            return true;
+    }
+    return false;
+}
+
+bool Debugger::evaluate(const BreakpointCondition &condition) const {
+    uint16_t actual = condition.reg == DEBUGGER_REGISTER_I
+        ? chip8.getIndexPointer()
+        : chip8.getRegister(condition.reg);
+    switch(condition.comparison) {
+        case Comparison::EQUAL:
+            return actual == condition.value;
+        case Comparison::NOT_EQUAL:
+            return actual != condition.value;
+        case Comparison::LESS:
+            return actual < condition.value;
+        case Comparison::GREATER:
+            return actual > condition.value;
+    }
+    return false;
+}
+
+void Debugger::onMemoryAccess(uint16_t address, bool write) {
+    for(auto &watchpoint: watchpoints) {
+        if(address < watchpoint.first || address > watchpoint.last)
+            continue;
+        if((write && watchpoint.onWrite) || (!write && watchpoint.onRead)) {
+            char message[96];
+            snprintf(message, sizeof(message), "Watchpoint %d: %s of %03X by instruction at %03X",
+                watchpoint.id, write ? "write" : "read", address,
+                chip8.getProgramCounter() - 2);
+            stop(message);
+            return;
+        }
+    }
+}
+
+void Debugger::stop(std::string message) {
+    paused = true;
+    pendingSteps = 0;
+    stopMessage = message;
+}
+
+void Debugger::pause() {
+    stop("Paused");
+}
+
+void Debugger::resume() {
+    paused = false;
+    pendingSteps = 0;
+    skipBreakpointOnce = true;
+}
+
+void Debugger::step(int count) {
+    paused = true;
+    pendingSteps = std::max(count, 1);
+}
+
+int Debugger::addBreakpoint(std::optional<uint16_t> address,
+    std::optional<BreakpointCondition> condition) {
+    breakpoints.push_back({nextId, address, condition});
+    rebuildIndexes();
+    return nextId++;
+}
+
+int Debugger::addWatchpoint(uint16_t first, uint16_t last, bool onRead, bool onWrite) {
+    watchpoints.push_back({nextId, first, last, onRead, onWrite});
+    rebuildIndexes();
+    return nextId++;
+}
+
+bool Debugger::remove(int id) {
+    auto sizeBefore = breakpoints.size() + watchpoints.size();
+    breakpoints.erase(std::remove_if(breakpoints.begin(), breakpoints.end(),
+        [id](auto &breakpoint) { return breakpoint.id == id; }), breakpoints.end());
+    watchpoints.erase(std::remove_if(watchpoints.begin(), watchpoints.end(),
+        [id](auto &watchpoint) { return watchpoint.id == id; }), watchpoints.end());
+    rebuildIndexes();
+    return breakpoints.size() + watchpoints.size() != sizeBefore;
+}
+
+void Debugger::rebuildIndexes() {
+    addressBreakpoints.reset();
+    hasAddresslessBreakpoints = false;
+    for(auto &breakpoint: breakpoints) {
+        if(!breakpoint.address) {
+            hasAddresslessBreakpoints = true;
+        } else if(*breakpoint.address < XOCHIP_MEMORY_SIZE) {
+            addressBreakpoints.set(*breakpoint.address);
+        }
+    }
+
+    Chip8PageSet readPages;
+    Chip8PageSet writePages;
+    for(auto &watchpoint: watchpoints) {
+        for(int page = watchpoint.first >> 8; page <= (watchpoint.last >> 8); ++page) {
+            if(watchpoint.onRead)
+                readPages.set(page);
+            if(watchpoint.onWrite)
+                writePages.set(page);
+        }
+    }
+    chip8.setWatchedPages(readPages, writePages);
+}
+
+const std::vector<Breakpoint> &Debugger::getBreakpoints() const {
+    return breakpoints;
+}
+
+const std::vector<Watchpoint> &Debugger::getWatchpoints() const {
+    return watchpoints;
+}
+
+std::optional<std::string> Debugger::takeStopMessage() {
+    auto message = stopMessage;
+    stopMessage.reset();
+    return message;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <bitset>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "Chip8.h"
+
+enum DEBUGGER_REGISTER {
+    DEBUGGER_REGISTER_V0 = 0x0,
+    DEBUGGER_REGISTER_VF = 0xF,
+    DEBUGGER_REGISTER_I = 0x10
+};
+
+enum class Comparison {
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    GREATER
+};
+
+struct BreakpointCondition {
+    int reg;
+    Comparison comparison;
+    uint16_t value;
+};
+
+struct Breakpoint {
+    int id;
+    std::optional<uint16_t> address;
+    std::optional<BreakpointCondition> condition;
+};
+
+struct Watchpoint {
+    int id;
+    uint16_t first;
+    uint16_t last;
+    bool onRead;
+    bool onWrite;
+};
+
+class Debugger {
+    Chip8 &chip8;
+    std::vector<Breakpoint> breakpoints;
+    std::vector<Watchpoint> watchpoints;
+    std::bitset<XOCHIP_MEMORY_SIZE> addressBreakpoints;
+    bool hasAddresslessBreakpoints = false;
+    int nextId = 1;
+
+    bool paused = false;
+    int pendingSteps = 0;
+    bool skipBreakpointOnce = false;
+    std::optional<std::string> stopMessage;
+
+    bool evaluate(const BreakpointCondition &condition) const;
+    bool hitsBreakpoint(uint16_t programCounter) const;
+    void stop(std::string message);
+    void rebuildIndexes();
+    int run(int instructions, uint32_t cycleBudget, uint32_t &cyclesSpent);
+
+    public:
+    Debugger(Chip8 &chip8);
+    ~Debugger();
+
+    bool isArmed() const;
+    bool isPaused() const;
+    int runCycles(int cycles);
+    // Like Chip8::runBudget, stopping early on a breakpoint
+    int runBudget(uint32_t cycleBudget, uint32_t &cyclesSpent);
+    void pause();
+    void resume();
+    void step(int count);
+
+    int addBreakpoint(std::optional<uint16_t> address,
+        std::optional<BreakpointCondition> condition);
+    int addWatchpoint(uint16_t first, uint16_t last, bool onRead, bool onWrite);
+    bool remove(int id);
+    const std::vector<Breakpoint> &getBreakpoints() const;
+    const std::vector<Watchpoint> &getWatchpoints() const;
+
+    void onMemoryAccess(uint16_t address, bool write);
+    std::optional<std::string> takeStopMessage();
+};
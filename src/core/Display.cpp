@@ -1,34 +1,192 @@
 #include "Display.h"
+#include <algorithm>
 
 
 void Display::clear() {
-    for(auto &row: data) {
-        for(auto &pixel: row) {
-            pixel = false;
+    for(unsigned int plane = 0; plane < DISPLAY_PLANES; ++plane) {
+        if(selectedPlanes >> plane & 1) {
+            for(auto &row: data.planes[plane]) {
+                row.fill(0);
+            }
         }
     }
 }
 
-bool Display::drawSprite(int x, int y, std::vector<uint8_t> pixels) {
+// Sprite data holds one sprite per selected plane, lowest plane first
+bool Display::drawSprite(int x, int y, std::vector<uint8_t> pixels, int spriteWidth) {
+    unsigned int planeCount = getSelectedPlaneCount();
+    if(planeCount == 0)
+        return false;
+    int bytesPerRow = spriteWidth / 8;
+    int height = pixels.size() / planeCount / bytesPerRow;
     bool collision = false;
-    for(int currentByteIndex = 0, row = y;
-        currentByteIndex < pixels.size() && row < HEIGHT;
-        ++row, ++currentByteIndex) {
-        for(int bitPosition = 0, column = x;
-            bitPosition < 8 && column < WIDTH;
-            ++bitPosition, ++column
-        ) {
-            bool bitState = (pixels[currentByteIndex] >> (7 - bitPosition) & 0x01); 
-            if(bitState) {
-                if(data[row][column])
-                    collision = true;
-                data[row][column] = !data[row][column];
-            }
+    const uint8_t *sprite = pixels.data();
+    for(unsigned int plane = 0; plane < DISPLAY_PLANES; ++plane) {
+        if(selectedPlanes >> plane & 1) {
+            collision |= drawPlane(data.planes[plane], x, y, sprite, height, spriteWidth);
+            sprite += height * bytesPerRow;
+        }
+    }
+    return collision;
+}
+
+bool Display::drawPlane(PlaneRows &rows, int x, int y, const uint8_t *pixels, int height, int spriteWidth) {
+    bool collision = false;
+    int bytesPerRow = spriteWidth / 8;
+    int firstWord = x / 64;
+    int shift = 64 - spriteWidth - x % 64;
+    int screenHeight = getHeight();
+    int words = visibleWords();
+    for(int i = 0; i < height; ++i) {
+        int row = y + i;
+        if(row >= screenHeight) {
+            if(!wrapping)
+                break;
+            row %= screenHeight;
+        }
+        uint64_t spriteRow = 0;
+        for(int j = 0; j < bytesPerRow; ++j) {
+            spriteRow = spriteRow << 8 | pixels[i * bytesPerRow + j];
+        }
+
+        auto &line = rows[row];
+        uint64_t left = shift >= 0 ? spriteRow << shift : spriteRow >> -shift;
+        collision |= (line[firstWord] & left) != 0;
+        line[firstWord] ^= left;
+        if(shift < 0 && (firstWord + 1 < words || wrapping)) {
+            auto &spill = line[(firstWord + 1) % words];
+            uint64_t right = spriteRow << (64 + shift);
+            collision |= (spill & right) != 0;
+            spill ^= right;
         }
     }
     return collision;
 }
 
+void Display::scrollDown(int rows) {
+    for(unsigned int plane = 0; plane < DISPLAY_PLANES; ++plane) {
+        if(selectedPlanes >> plane & 1)
+            scrollPlaneDown(data.planes[plane], rows);
+    }
+}
+
+void Display::scrollUp(int rows) {
+    for(unsigned int plane = 0; plane < DISPLAY_PLANES; ++plane) {
+        if(selectedPlanes >> plane & 1)
+            scrollPlaneUp(data.planes[plane], rows);
+    }
+}
+
+void Display::scrollRight(int pixels) {
+    if(pixels <= 0)
+        return;
+    for(unsigned int plane = 0; plane < DISPLAY_PLANES; ++plane) {
+        if(selectedPlanes >> plane & 1)
+            scrollPlaneRight(data.planes[plane], pixels);
+    }
+}
+
+void Display::scrollLeft(int pixels) {
+    if(pixels <= 0)
+        return;
+    for(unsigned int plane = 0; plane < DISPLAY_PLANES; ++plane) {
+        if(selectedPlanes >> plane & 1)
+            scrollPlaneLeft(data.planes[plane], pixels);
+    }
+}
+
+void Display::scrollPlaneDown(PlaneRows &rows, int count) {
+    int height = getHeight();
+    count = std::min(count, height);
+    for(int row = height - 1; row >= count; --row) {
+        rows[row] = rows[row - count];
+    }
+    for(int row = 0; row < count; ++row) {
+        rows[row].fill(0);
+    }
+}
+
+void Display::scrollPlaneUp(PlaneRows &rows, int count) {
+    int height = getHeight();
+    count = std::min(count, height);
+    for(int row = 0; row + count < height; ++row) {
+        rows[row] = rows[row + count];
+    }
+    for(int row = height - count; row < height; ++row) {
+        rows[row].fill(0);
+    }
+}
+
+void Display::scrollPlaneRight(PlaneRows &rows, int pixels) {
+    unsigned int words = visibleWords();
+    for(unsigned int row = 0; row < getHeight(); ++row) {
+        auto &line = rows[row];
+        for(int word = words - 1; word > 0; --word) {
+            line[word] = line[word] >> pixels | line[word - 1] << (64 - pixels);
+        }
+        line[0] >>= pixels;
+    }
+}
+
+void Display::scrollPlaneLeft(PlaneRows &rows, int pixels) {
+    unsigned int words = visibleWords();
+    for(unsigned int row = 0; row < getHeight(); ++row) {
+        auto &line = rows[row];
+        for(unsigned int word = 0; word + 1 < words; ++word) {
+            line[word] = line[word] << pixels | line[word + 1] >> (64 - pixels);
+        }
+        line[words - 1] <<= pixels;
+    }
+}
+
+void Display::setHighResolution(bool highResolution) {
+    data.highResolution = highResolution;
+    for(auto &plane: data.planes) {
+        for(auto &row: plane) {
+            row.fill(0);
+        }
+    }
+}
+
+bool Display::isHighResolution() const {
+    return data.highResolution;
+}
+
+void Display::selectPlanes(uint8_t planes) {
+    selectedPlanes = planes & ((1 << DISPLAY_PLANES) - 1);
+}
+
+uint8_t Display::getSelectedPlanes() const {
+    return selectedPlanes;
+}
+
+unsigned int Display::getSelectedPlaneCount() const {
+    unsigned int count = 0;
+    for(unsigned int plane = 0; plane < DISPLAY_PLANES; ++plane)
+        count += selectedPlanes >> plane & 1;
+    return count;
+}
+
+void Display::setWrapping(bool wrapping) {
+    this->wrapping = wrapping;
+}
+
+unsigned int Display::getWidth() const {
+    return data.getWidth();
+}
+
+unsigned int Display::getHeight() const {
+    return data.getHeight();
+}
+
+unsigned int Display::visibleWords() const {
+    return getWidth() / 64;
+}
+
 PixelMatrix Display::getData() {
     return data;
-}
\ No newline at end of file
+}
+
+void Display::setData(const PixelMatrix &pixels) {
+    data = pixels;
+}
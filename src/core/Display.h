@@ -5,14 +5,76 @@
 
 constexpr unsigned int WIDTH = 64;
 constexpr unsigned int HEIGHT = 32;
+constexpr unsigned int HIRES_WIDTH = 128;
+constexpr unsigned int HIRES_HEIGHT = 64;
+constexpr unsigned int ROW_WORDS = HIRES_WIDTH / 64;
+constexpr unsigned int DISPLAY_PLANES = 2;
 
-typedef std::array<std::array<bool, WIDTH>, HEIGHT> PixelMatrix;
+// ARGB color for each combination of lit planes
+constexpr uint32_t DISPLAY_PALETTE[1 << DISPLAY_PLANES] = {
+    0xFF000000, 0xFFFFFFFF, 0xFFAAAAAA, 0xFF555555
+};
+
+typedef std::array<std::array<uint64_t, ROW_WORDS>, HIRES_HEIGHT> PlaneRows;
+
+// Each plane stores rows packed 64 pixels per word, leftmost pixel in the
+// most significant bit. Low resolution mode uses the top-left 64x32 corner
+// of the buffer. A pixel's color index has bit n set when plane n is lit.
+struct PixelMatrix {
+    std::array<PlaneRows, DISPLAY_PLANES> planes {};
+    bool highResolution = false;
+
+    unsigned int getWidth() const {
+        return highResolution ? HIRES_WIDTH : WIDTH;
+    }
+
+    unsigned int getHeight() const {
+        return highResolution ? HIRES_HEIGHT : HEIGHT;
+    }
+
+    unsigned int getPixel(unsigned int x, unsigned int y) const {
+        unsigned int color = 0;
+        for(unsigned int plane = 0; plane < DISPLAY_PLANES; ++plane)
+            color |= (planes[plane][y][x / 64] >> (63 - x % 64) & 1) << plane;
+        return color;
+    }
+
+    bool operator==(const PixelMatrix &other) const {
+        return highResolution == other.highResolution && planes == other.planes;
+    }
+
+    bool operator!=(const PixelMatrix &other) const {
+        return !(*this == other);
+    }
+};
 
 class Display {
     PixelMatrix data {};
+    uint8_t selectedPlanes = 1;
+    bool wrapping = false;
+
+    unsigned int visibleWords() const;
+    bool drawPlane(PlaneRows &rows, int x, int y, const uint8_t *pixels, int height, int spriteWidth);
+    void scrollPlaneDown(PlaneRows &rows, int count);
+    void scrollPlaneUp(PlaneRows &rows, int count);
+    void scrollPlaneRight(PlaneRows &rows, int pixels);
+    void scrollPlaneLeft(PlaneRows &rows, int pixels);
 
     public:
         void clear();
-        bool drawSprite(int x, int y, std::vector<uint8_t> pixels);
+        bool drawSprite(int x, int y, std::vector<uint8_t> pixels, int spriteWidth = 8);
+        void scrollDown(int rows);
+        void scrollUp(int rows);
+        void scrollRight(int pixels);
+        void scrollLeft(int pixels);
+        void setHighResolution(bool highResolution);
+        bool isHighResolution() const;
+        void selectPlanes(uint8_t planes);
+        uint8_t getSelectedPlanes() const;
+        unsigned int getSelectedPlaneCount() const;
+        void setWrapping(bool wrapping);
+        unsigned int getWidth() const;
+        unsigned int getHeight() const;
         PixelMatrix getData();
-};
\ No newline at end of file
+        void setData(const PixelMatrix &pixels);
+};
@@ -0,0 +1,143 @@
+#include "Lockstep.h"
+#include <cstdio>
+#include <algorithm>
+
+namespace {
+
+std::string format(const char *text, unsigned int expected, unsigned int actual) {
+    char line[96];
+    snprintf(line, sizeof(line), text, expected, actual);
+    return line;
+}
+
+}
+
+LockstepRunner::LockstepRunner(Chip8 &_reference, Chip8 &_candidate,
+    unsigned int _compareInterval, unsigned int _instructionsPerFrame):
+    reference({_reference, std::vector<TraceRecord>(LOCKSTEP_TRACE_WINDOW), CHIP8_FAULT_NONE}),
+    candidate({_candidate, std::vector<TraceRecord>(LOCKSTEP_TRACE_WINDOW), CHIP8_FAULT_NONE}),
+    compareInterval(std::max(_compareInterval, 1u)),
+    instructionsPerFrame(std::max(_instructionsPerFrame, 1u)) {
+    reference.chip8.setTrapPolicy(CHIP8_TRAP_SKIP);
+    candidate.chip8.setTrapPolicy(CHIP8_TRAP_SKIP);
+}
+
+std::optional<LockstepDivergence> LockstepRunner::run(uint64_t instructions) {
+    for(uint64_t i = 0; i < instructions; ++i) {
+        step(reference);
+        step(candidate);
+        ++executed;
+        if(executed % instructionsPerFrame == 0) {
+            reference.chip8.tickTimers();
+            candidate.chip8.tickTimers();
+        }
+        auto differences = compareRegisters();
+        if(!differences.empty() || executed % compareInterval == 0 || i + 1 == instructions)
+            compareMemory(differences);
+        if(!differences.empty()) {
+            return LockstepDivergence {executed, differences,
+                orderedWindow(reference), orderedWindow(candidate)};
+        }
+    }
+    return std::nullopt;
+}
+
+void LockstepRunner::step(Engine &engine) {
+    auto &chip8 = engine.chip8;
+    auto &record = engine.window[executed % LOCKSTEP_TRACE_WINDOW];
+    record.programCounter = chip8.getProgramCounter();
+    record.opcode = (chip8.peekMemory(record.programCounter) << 8)
+        | chip8.peekMemory(record.programCounter + 1);
+    uint8_t previousVariables[16];
+    for(int i = 0; i < 16; ++i)
+        previousVariables[i] = chip8.getRegister(i);
+
+    auto trapsBefore = chip8.getTrapCount();
+    chip8.doNextCycle();
+    engine.fault = chip8.getTrapCount() != trapsBefore
+        ? chip8.getLastTrap().fault : CHIP8_FAULT_NONE;
+
+    record.indexPointer = chip8.getIndexPointer();
+    record.changedRegisters = 0;
+    for(int i = 0; i < 16; ++i) {
+        record.variables[i] = chip8.getRegister(i);
+        if(record.variables[i] != previousVariables[i])
+            record.changedRegisters |= 1 << i;
+    }
+}
+
+std::vector<std::string> LockstepRunner::compareRegisters() {
+    std::vector<std::string> differences;
+    auto &expected = reference.chip8;
+    auto &actual = candidate.chip8;
+
+    if(reference.fault != candidate.fault) {
+        differences.push_back(std::string("fault: ") + describeFault(reference.fault)
+            + " vs " + describeFault(candidate.fault));
+    }
+    if(expected.getProgramCounter() != actual.getProgramCounter()) {
+        differences.push_back(format("PC: %03X vs %03X",
+            expected.getProgramCounter(), actual.getProgramCounter()));
+    }
+    if(expected.getIndexPointer() != actual.getIndexPointer()) {
+        differences.push_back(format("I: %03X vs %03X",
+            expected.getIndexPointer(), actual.getIndexPointer()));
+    }
+    for(int i = 0; i < 16; ++i) {
+        if(expected.getRegister(i) != actual.getRegister(i)) {
+            char text[32];
+            snprintf(text, sizeof(text), "V%X: %%02X vs %%02X", i);
+            differences.push_back(format(text, expected.getRegister(i), actual.getRegister(i)));
+        }
+    }
+    if(expected.getStackDepth() != actual.getStackDepth()) {
+        differences.push_back(format("stack: depth %u vs %u",
+            expected.getStackDepth(), actual.getStackDepth()));
+    }
+    return differences;
+}
+
+void LockstepRunner::compareMemory(std::vector<std::string> &differences) {
+    auto &expected = reference.chip8;
+    auto &actual = candidate.chip8;
+
+    if(expected.getStackDepth() == actual.getStackDepth() && expected.getStack() != actual.getStack()) {
+        differences.push_back("stack: return addresses differ");
+    }
+    if(expected.getMemorySize() != actual.getMemorySize()) {
+        differences.push_back(format("memory size: %u vs %u",
+            expected.getMemorySize(), actual.getMemorySize()));
+    } else if(expected.hashMemory() != actual.hashMemory()) {
+        for(unsigned int address = 0; address < expected.getMemorySize(); ++address) {
+            if(expected.peekMemory(address) != actual.peekMemory(address)) {
+                char text[48];
+                snprintf(text, sizeof(text), "memory[%04X]: %%02X vs %%02X", address);
+                differences.push_back(format(text,
+                    expected.peekMemory(address), actual.peekMemory(address)));
+                break;
+            }
+        }
+    }
+    auto expectedPixels = expected.peek();
+    auto actualPixels = actual.peek();
+    if(expectedPixels != actualPixels) {
+        unsigned int differingPixels = 0;
+        for(unsigned int y = 0; y < HIRES_HEIGHT; ++y)
+            for(unsigned int x = 0; x < HIRES_WIDTH; ++x)
+                differingPixels += expectedPixels.getPixel(x, y) != actualPixels.getPixel(x, y);
+        differences.push_back(format("framebuffer: %u of %u pixels differ",
+            differingPixels, expectedPixels.getWidth() * expectedPixels.getHeight()));
+        if(expectedPixels.highResolution != actualPixels.highResolution)
+            differences.push_back(format("display width: %u vs %u",
+                expectedPixels.getWidth(), actualPixels.getWidth()));
+    }
+}
+
+std::vector<TraceRecord> LockstepRunner::orderedWindow(const Engine &engine) const {
+    std::vector<TraceRecord> ordered;
+    auto length = std::min<uint64_t>(executed, LOCKSTEP_TRACE_WINDOW);
+    for(uint64_t i = executed - length; i < executed; ++i) {
+        ordered.push_back(engine.window[i % LOCKSTEP_TRACE_WINDOW]);
+    }
+    return ordered;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "Chip8.h"
+
+constexpr unsigned int LOCKSTEP_TRACE_WINDOW = 32;
+constexpr unsigned int LOCKSTEP_DEFAULT_COMPARE_INTERVAL = 1000;
+
+struct LockstepDivergence {
+    uint64_t instruction;
+    std::vector<std::string> differences;
+    std::vector<TraceRecord> referenceWindow;
+    std::vector<TraceRecord> candidateWindow;
+};
+
+// Runs two engines on the same input. Faults, PC, I, V0-VF and stack depth
+// are compared after every instruction; memory, stack contents and the
+// framebuffer, which cost far more to compare, every compareInterval
+// instructions, at the end of the run and on any register divergence.
+// Both engines skip over traps so a fault shows up as a difference instead
+// of stopping the run.
+class LockstepRunner {
+    struct Engine {
+        Chip8 &chip8;
+        std::vector<TraceRecord> window;
+        CHIP8_FAULT fault = CHIP8_FAULT_NONE;
+    };
+
+    Engine reference;
+    Engine candidate;
+    unsigned int compareInterval;
+    unsigned int instructionsPerFrame;
+    uint64_t executed = 0;
+
+    void step(Engine &engine);
+    std::vector<std::string> compareRegisters();
+    void compareMemory(std::vector<std::string> &differences);
+    std::vector<TraceRecord> orderedWindow(const Engine &engine) const;
+
+    public:
+    LockstepRunner(Chip8 &reference, Chip8 &candidate,
+        unsigned int compareInterval, unsigned int instructionsPerFrame);
+    std::optional<LockstepDivergence> run(uint64_t instructions);
+};
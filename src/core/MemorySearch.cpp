@@ -0,0 +1,196 @@
+#include "MemorySearch.h"
+#include <algorithm>
+#include <bitset>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// One bit per byte of a SEARCH_BLOCK_SIZE block, set where the comparison holds
+#if defined(__SSE2__)
+uint64_t compareBlock(const uint8_t *current, const uint8_t *previous,
+    SearchComparison comparison, uint8_t operand) {
+    // SSE2 only compares signed bytes; flipping the top bit orders them unsigned
+    const __m128i bias = _mm_set1_epi8(char(0x80));
+    const __m128i value = _mm_set1_epi8(char(operand));
+    const __m128i biasedValue = _mm_xor_si128(value, bias);
+    uint64_t mask = 0;
+    for(unsigned int offset = 0; offset < SEARCH_BLOCK_SIZE; offset += 16) {
+        auto now = _mm_loadu_si128(reinterpret_cast<const __m128i *>(current + offset));
+        auto before = _mm_loadu_si128(reinterpret_cast<const __m128i *>(previous + offset));
+        __m128i hits;
+        int invert = 0;
+        switch(comparison) {
+            case SearchComparison::EQUAL:
+                hits = _mm_cmpeq_epi8(now, value);
+                break;
+            case SearchComparison::NOT_EQUAL:
+                hits = _mm_cmpeq_epi8(now, value);
+                invert = 0xFFFF;
+                break;
+            case SearchComparison::LESS:
+                hits = _mm_cmplt_epi8(_mm_xor_si128(now, bias), biasedValue);
+                break;
+            case SearchComparison::GREATER:
+                hits = _mm_cmpgt_epi8(_mm_xor_si128(now, bias), biasedValue);
+                break;
+            case SearchComparison::CHANGED:
+                hits = _mm_cmpeq_epi8(now, before);
+                invert = 0xFFFF;
+                break;
+            case SearchComparison::UNCHANGED:
+                hits = _mm_cmpeq_epi8(now, before);
+                break;
+            case SearchComparison::INCREASED:
+                hits = _mm_cmpgt_epi8(_mm_xor_si128(now, bias), _mm_xor_si128(before, bias));
+                break;
+            case SearchComparison::DECREASED:
+                hits = _mm_cmplt_epi8(_mm_xor_si128(now, bias), _mm_xor_si128(before, bias));
+                break;
+            case SearchComparison::INCREASED_BY:
+                hits = _mm_cmpeq_epi8(_mm_sub_epi8(now, before), value);
+                break;
+            default:
+                hits = _mm_cmpeq_epi8(_mm_sub_epi8(before, now), value);
+                break;
+        }
+        mask |= uint64_t(_mm_movemask_epi8(hits) ^ invert) << offset;
+    }
+    return mask;
+}
+#else
+uint64_t compareBlock(const uint8_t *current, const uint8_t *previous,
+    SearchComparison comparison, uint8_t operand) {
+    uint64_t mask = 0;
+    for(unsigned int i = 0; i < SEARCH_BLOCK_SIZE; ++i)
+        mask |= uint64_t(searchMatches(current[i], previous[i], comparison, operand)) << i;
+    return mask;
+}
+#endif
+
+}
+
+bool searchMatches(uint8_t current, uint8_t previous, SearchComparison comparison, uint8_t operand) {
+    switch(comparison) {
+        case SearchComparison::EQUAL:
+            return current == operand;
+        case SearchComparison::NOT_EQUAL:
+            return current != operand;
+        case SearchComparison::LESS:
+            return current < operand;
+        case SearchComparison::GREATER:
+            return current > operand;
+        case SearchComparison::CHANGED:
+            return current != previous;
+        case SearchComparison::UNCHANGED:
+            return current == previous;
+        case SearchComparison::INCREASED:
+            return current > previous;
+        case SearchComparison::DECREASED:
+            return current < previous;
+        case SearchComparison::INCREASED_BY:
+            return uint8_t(current - previous) == operand;
+        case SearchComparison::DECREASED_BY:
+            return uint8_t(previous - current) == operand;
+    }
+    return false;
+}
+
+uint8_t readLocation(const Chip8 &chip8, uint32_t location) {
+    if(location >= SEARCH_REGISTER_BASE)
+        return chip8.getRegister((location - SEARCH_REGISTER_BASE) & 0xF);
+    return chip8.peekMemory(location);
+}
+
+void MemorySearch::capture(const Chip8 &chip8, std::vector<uint8_t> &snapshot) {
+    auto &memory = chip8.getMemory();
+    snapshot.assign(candidates.size() * SEARCH_BLOCK_SIZE, 0);
+    std::copy(memory.begin(), memory.end(), snapshot.begin());
+    for(int i = 0; i < 16; ++i)
+        snapshot[memory.size() + i] = chip8.getRegister(i);
+}
+
+uint32_t MemorySearch::toLocation(size_t index) const {
+    return index < memorySize ? index : SEARCH_REGISTER_BASE + (index - memorySize);
+}
+
+void MemorySearch::start(const Chip8 &chip8) {
+    memorySize = chip8.getMemorySize();
+    candidateCount = memorySize + 16;
+    candidates.assign((candidateCount + SEARCH_BLOCK_SIZE - 1) / SEARCH_BLOCK_SIZE, ~uint64_t(0));
+    if(candidateCount % SEARCH_BLOCK_SIZE != 0)
+        candidates.back() = (uint64_t(1) << candidateCount % SEARCH_BLOCK_SIZE) - 1;
+    capture(chip8, current);
+    previous = current;
+}
+
+// Takes a new snapshot and keeps the candidates for which the comparison
+// holds between it and the one before.
+size_t MemorySearch::filter(const Chip8 &chip8, SearchComparison comparison, uint8_t operand) {
+    if(!isStarted() || chip8.getMemorySize() != memorySize)
+        start(chip8);
+    previous.swap(current);
+    capture(chip8, current);
+    candidateCount = 0;
+    for(size_t block = 0; block < candidates.size(); ++block) {
+        if(candidates[block] == 0)
+            continue;
+        auto offset = block * SEARCH_BLOCK_SIZE;
+        candidates[block] &= compareBlock(&current[offset], &previous[offset], comparison, operand);
+        candidateCount += std::bitset<64>(candidates[block]).count();
+    }
+    return candidateCount;
+}
+
+bool MemorySearch::isStarted() const {
+    return !candidates.empty();
+}
+
+size_t MemorySearch::getCandidateCount() const {
+    return candidateCount;
+}
+
+std::vector<uint32_t> MemorySearch::getCandidates(size_t limit) const {
+    std::vector<uint32_t> locations;
+    for(size_t block = 0; block < candidates.size() && locations.size() < limit; ++block) {
+        for(auto bits = candidates[block]; bits != 0 && locations.size() < limit; bits &= bits - 1) {
+            unsigned int bit = 0;
+            while(!(bits >> bit & 1))
+                ++bit;
+            locations.push_back(toLocation(block * SEARCH_BLOCK_SIZE + bit));
+        }
+    }
+    return locations;
+}
+
+uint8_t MemorySearch::getPreviousValue(uint32_t location) const {
+    return previous[location >= SEARCH_REGISTER_BASE ? memorySize + (location - SEARCH_REGISTER_BASE) : location];
+}
+
+uint8_t MemorySearch::getCurrentValue(uint32_t location) const {
+    return current[location >= SEARCH_REGISTER_BASE ? memorySize + (location - SEARCH_REGISTER_BASE) : location];
+}
+
+void MemorySearch::setWatch(const std::string &name, uint32_t location) {
+    for(auto &watch: watches) {
+        if(watch.name == name) {
+            watch.location = location;
+            return;
+        }
+    }
+    watches.push_back({name, location});
+}
+
+bool MemorySearch::removeWatch(const std::string &name) {
+    auto watch = std::find_if(watches.begin(), watches.end(),
+        [&](const MemoryWatch &watch) { return watch.name == name; });
+    if(watch == watches.end())
+        return false;
+    watches.erase(watch);
+    return true;
+}
+
+const std::vector<MemoryWatch> &MemorySearch::getWatches() const {
+    return watches;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Chip8.h"
+
+// Search locations cover memory and, above it, V0-VF, so a location keeps
+// its meaning whatever the memory size of the implementation.
+constexpr uint32_t SEARCH_REGISTER_BASE = XOCHIP_MEMORY_SIZE;
+constexpr uint32_t SEARCH_BLOCK_SIZE = 64;
+
+enum class SearchComparison {
+    // Against the operand
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    GREATER,
+    // Against the previous snapshot
+    CHANGED,
+    UNCHANGED,
+    INCREASED,
+    DECREASED,
+    INCREASED_BY,
+    DECREASED_BY
+};
+
+struct MemoryWatch {
+    std::string name;
+    uint32_t location;
+};
+
+bool searchMatches(uint8_t current, uint8_t previous, SearchComparison comparison, uint8_t operand);
+uint8_t readLocation(const Chip8 &chip8, uint32_t location);
+
+// Narrows down where a rom keeps a value (score, lives, a timer) by taking
+// snapshots of memory and registers and keeping only the locations that
+// behaved as asked between the last two. Candidates are a bitset that
+// every filter intersects with a mask built 16 bytes at a time, and blocks
+// with no candidates left are skipped. Found locations can be given names;
+// watches are read straight from the core and published with --shm.
+class MemorySearch {
+    std::vector<uint8_t> current;
+    std::vector<uint8_t> previous;
+    std::vector<uint64_t> candidates;
+    size_t memorySize = 0;
+    size_t candidateCount = 0;
+    std::vector<MemoryWatch> watches;
+
+    void capture(const Chip8 &chip8, std::vector<uint8_t> &snapshot);
+    uint32_t toLocation(size_t index) const;
+
+    public:
+    void start(const Chip8 &chip8);
+    size_t filter(const Chip8 &chip8, SearchComparison comparison, uint8_t operand = 0);
+    bool isStarted() const;
+    size_t getCandidateCount() const;
+    // Up to limit candidate locations, lowest first
+    std::vector<uint32_t> getCandidates(size_t limit) const;
+    uint8_t getPreviousValue(uint32_t location) const;
+    uint8_t getCurrentValue(uint32_t location) const;
+
+    void setWatch(const std::string &name, uint32_t location);
+    bool removeWatch(const std::string &name);
+    const std::vector<MemoryWatch> &getWatches() const;
+};
@@ -1,6 +1,67 @@
 #include "OriginalChip8.h"
+#include <array>
 
-OriginalChip8::OriginalChip8(const Chip8Keyboard &keyboard): Chip8(keyboard) {}
+namespace {
+
+// What the VIP interpreter's routine for each first nibble costs on top of
+// fetch and decode. Variable parts are added in getInstructionCycles; skips
+// are counted as not taken.
+constexpr std::array<uint16_t, 16> COSMAC_VIP_INSTRUCTION_CYCLES = {
+    10, // 00EE, 00E0 clears on top
+    12, // 1NNN
+    26, // 2NNN
+    10, // 3XNN
+    10, // 4XNN
+    14, // 5XY0
+    6,  // 6XNN
+    10, // 7XNN
+    44, // 8XYN
+    14, // 9XY0
+    12, // ANNN
+    22, // BNNN
+    36, // CXNN
+    22, // DXYN, plus each row
+    14, // EX9E, EXA1
+    10  // FXNN, some add more
+};
+
+}
+
+OriginalChip8::OriginalChip8(const Chip8Keyboard &keyboard): Chip8(keyboard) {
+    timing.cyclesPerFrame = COSMAC_VIP_CYCLES_PER_FRAME;
+    timing.displayWait = true;
+}
+
+uint32_t OriginalChip8::getInstructionCycles(uint16_t instruction) const {
+    uint32_t cycles = COSMAC_VIP_FETCH_CYCLES + COSMAC_VIP_INSTRUCTION_CYCLES[instruction >> 12];
+    uint32_t x = (instruction >> 8) & 0xF;
+    switch(instruction >> 12) {
+        case 0x0:
+            // 256 display bytes at 12 cycles each
+            if(instruction == 0x00E0)
+                cycles += 14 + 256 * 12;
+            break;
+        case 0xD:
+            cycles += 34 * (instruction & 0xF);
+            break;
+        case 0xF:
+            switch(instruction & 0xFF) {
+                case 0x1E:
+                case 0x29:
+                    cycles += 6;
+                    break;
+                case 0x33:
+                    cycles += 74;
+                    break;
+                case 0x55:
+                case 0x65:
+                    cycles += 4 + 14 * (x + 1);
+                    break;
+            }
+            break;
+    }
+    return cycles;
+}
 
 void OriginalChip8::shiftRight(uint16_t instruction) {
     auto vy = getYRegister(instruction);
@@ -25,14 +86,14 @@ void OriginalChip8::jumpWithOffset(uint16_t instruction) {
 void OriginalChip8::storeRegistersToMemory(uint16_t instruction) {
     auto x = getXIdx(instruction);
     for(uint8_t i = 0; i <= x; ++i, ++indexPointer) {
-        memory[indexPointer] = variables[i];
+        writeMemory(indexPointer, variables[i]);
     }
 }
 
 void OriginalChip8::loadRegistersFromMemory(uint16_t instruction) {
     auto x = getXIdx(instruction);
     for(uint8_t i = 0; i <= x; ++i, ++indexPointer) {
-        variables[i] = memory[indexPointer];
+        variables[i] = readMemory(indexPointer);
     }
 }
 
@@ -1,6 +1,12 @@
 #pragma once
 #include "Chip8.h"
 
+// COSMAC VIP timing in 1802 machine cycles of 8 clock periods at 1.7609 MHz.
+// The 1861 display takes 8 DMA cycles for each of the 128 visible lines out
+// of every frame, the interpreter gets the rest.
+constexpr uint32_t COSMAC_VIP_CYCLES_PER_FRAME = 1760900 / 8 / 60 - 128 * 8;
+constexpr uint32_t COSMAC_VIP_FETCH_CYCLES = 40;
+
 class OriginalChip8: public Chip8 {
     void shiftRight(uint16_t);
     void shiftLeft(uint16_t);
@@ -12,4 +18,5 @@ class OriginalChip8: public Chip8 {
     void logicalXor(uint16_t instruction);
     public:
     OriginalChip8(const Chip8Keyboard &keyboard);
+    uint32_t getInstructionCycles(uint16_t instruction) const;
 };
\ No newline at end of file
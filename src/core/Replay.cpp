@@ -0,0 +1,382 @@
+#include "Replay.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+void put8(std::vector<uint8_t> &out, uint8_t value) {
+    out.push_back(value);
+}
+
+void put16(std::vector<uint8_t> &out, uint16_t value) {
+    out.push_back(value & 0xFF);
+    out.push_back(value >> 8);
+}
+
+void put32(std::vector<uint8_t> &out, uint32_t value) {
+    put16(out, value & 0xFFFF);
+    put16(out, value >> 16);
+}
+
+void put64(std::vector<uint8_t> &out, uint64_t value) {
+    put32(out, value & 0xFFFFFFFF);
+    put32(out, value >> 32);
+}
+
+void patch32(std::vector<uint8_t> &out, size_t offset, uint32_t value) {
+    for(int i = 0; i < 4; ++i)
+        out[offset + i] = value >> (8 * i);
+}
+
+uint16_t get16(const uint8_t *data) {
+    return data[0] | (data[1] << 8);
+}
+
+uint32_t get32(const uint8_t *data) {
+    return get16(data) | (uint32_t(get16(data + 2)) << 16);
+}
+
+uint64_t get64(const uint8_t *data) {
+    return get32(data) | (uint64_t(get32(data + 4)) << 32);
+}
+
+// Bounds-checked reads for deserializeState
+class StateReader {
+    const uint8_t *data;
+    const uint8_t *end;
+
+    public:
+    bool valid = true;
+
+    StateReader(const uint8_t *_data, size_t size): data(_data), end(_data + size) {}
+
+    const uint8_t *take(size_t length) {
+        if(!valid || size_t(end - data) < length) {
+            valid = false;
+            return nullptr;
+        }
+        auto taken = data;
+        data += length;
+        return taken;
+    }
+
+    uint8_t read8() {
+        auto bytes = take(1);
+        return bytes ? bytes[0] : 0;
+    }
+
+    uint16_t read16() {
+        auto bytes = take(2);
+        return bytes ? get16(bytes) : 0;
+    }
+
+    uint32_t read32() {
+        auto bytes = take(4);
+        return bytes ? get32(bytes) : 0;
+    }
+
+    uint64_t read64() {
+        auto bytes = take(8);
+        return bytes ? get64(bytes) : 0;
+    }
+};
+
+}
+
+void serializeState(const Chip8State &state, std::vector<uint8_t> &out) {
+    put32(out, state.memory.size());
+    out.insert(out.end(), state.memory.begin(), state.memory.end());
+    put16(out, state.programCounter);
+    put16(out, state.indexPointer);
+    for(auto address: state.stack)
+        put16(out, address);
+    put8(out, state.stackPointer);
+    out.insert(out.end(), state.variables, state.variables + 16);
+    put8(out, state.delayTimer);
+    put8(out, state.soundTimer);
+    out.insert(out.end(), state.persistentFlags, state.persistentFlags + CHIP8_PERSISTENT_FLAGS_COUNT);
+    // The standard only guarantees the engine round trips through a stream
+    std::ostringstream stream;
+    stream << state.randomEngine;
+    auto random = stream.str();
+    put8(out, random.size());
+    out.insert(out.end(), random.begin(), random.end());
+    put8(out, state.display.highResolution);
+    for(auto &plane: state.display.planes) {
+        for(auto &row: plane) {
+            for(auto word: row)
+                put64(out, word);
+        }
+    }
+    put8(out, state.selectedPlanes);
+    put8(out, state.halted);
+    put64(out, state.cycleCount);
+}
+
+bool deserializeState(const uint8_t *data, size_t size, Chip8State &state) {
+    StateReader reader(data, size);
+    auto memorySize = reader.read32();
+    if(memorySize < CHIP8_MEMORY_SIZE || memorySize > XOCHIP_MEMORY_SIZE)
+        return false;
+    if(auto memory = reader.take(memorySize))
+        state.memory.assign(memory, memory + memorySize);
+    state.programCounter = reader.read16();
+    state.indexPointer = reader.read16();
+    for(auto &address: state.stack)
+        address = reader.read16();
+    state.stackPointer = reader.read8();
+    if(auto variables = reader.take(16))
+        memcpy(state.variables, variables, 16);
+    state.delayTimer = reader.read8();
+    state.soundTimer = reader.read8();
+    if(auto flags = reader.take(CHIP8_PERSISTENT_FLAGS_COUNT))
+        memcpy(state.persistentFlags, flags, CHIP8_PERSISTENT_FLAGS_COUNT);
+    auto randomLength = reader.read8();
+    if(auto random = reader.take(randomLength)) {
+        std::istringstream stream(std::string(random, random + randomLength));
+        stream >> state.randomEngine;
+    }
+    state.display.highResolution = reader.read8();
+    for(auto &plane: state.display.planes) {
+        for(auto &row: plane) {
+            for(auto &word: row)
+                word = reader.read64();
+        }
+    }
+    state.selectedPlanes = reader.read8();
+    state.halted = reader.read8();
+    state.cycleCount = reader.read64();
+    // restoreState trusts these, and the core indexes with them
+    return reader.valid && state.stackPointer <= CHIP8_STACK_SIZE && state.selectedPlanes <= 3;
+}
+
+ReplayWriter::ReplayWriter(const std::string &path, CHIP8_IMPLEMENTATION impl,
+    CHIP8_TRAP_POLICY trapPolicy, const Chip8 &chip8, unsigned int _checkpointInterval):
+    checkpointInterval(std::max(_checkpointInterval, 1u)) {
+    file = fopen(path.c_str(), "wb");
+    if(file == nullptr)
+        throw ReplayFileException("Could not create replay file " + path);
+    std::vector<uint8_t> header;
+    put32(header, REPLAY_MAGIC);
+    put16(header, REPLAY_VERSION);
+    put8(header, impl);
+    put8(header, trapPolicy);
+    put32(header, checkpointInterval);
+    fwrite(header.data(), 1, header.size(), file);
+    offset = header.size();
+    startSegment(chip8, REPLAY_SEGMENT_RESET);
+}
+
+ReplayWriter::~ReplayWriter() {
+    if(segmentFrames > 0 || index.empty())
+        flushSegment();
+    std::vector<uint8_t> footer;
+    for(auto &entry: index) {
+        put32(footer, entry.first);
+        put64(footer, entry.second);
+    }
+    put32(footer, index.size());
+    put64(footer, offset);
+    put32(footer, REPLAY_INDEX_MAGIC);
+    fwrite(footer.data(), 1, footer.size(), file);
+    fclose(file);
+}
+
+void ReplayWriter::addFrame(const Chip8 &chip8, uint16_t keys, uint32_t instructions) {
+    put16(segment, keys);
+    put32(segment, instructions);
+    ++segmentFrames;
+    ++frame;
+    if(segmentFrames >= checkpointInterval)
+        startSegment(chip8, 0);
+}
+
+void ReplayWriter::checkpoint(const Chip8 &chip8) {
+    startSegment(chip8, REPLAY_SEGMENT_RESET);
+}
+
+void ReplayWriter::startSegment(const Chip8 &chip8, uint32_t flags) {
+    if(segmentFrames > 0)
+        flushSegment();
+    else if(!segment.empty())
+        flags |= segment[12];
+    segment.clear();
+    put32(segment, REPLAY_SEGMENT_MAGIC);
+    put32(segment, frame);
+    put32(segment, 0);
+    put32(segment, flags);
+    put32(segment, 0);
+    chip8.saveState(state);
+    serializeState(state, segment);
+    patch32(segment, 16, segment.size() - REPLAY_SEGMENT_HEADER_SIZE);
+    segmentFirstFrame = frame;
+    segmentFrames = 0;
+}
+
+// Segments go out in one write, so a replay cut short by a crash still
+// ends on a whole segment most of the time.
+void ReplayWriter::flushSegment() {
+    patch32(segment, 8, segmentFrames);
+    fwrite(segment.data(), 1, segment.size(), file);
+    fflush(file);
+    index.push_back({segmentFirstFrame, offset});
+    offset += segment.size();
+    segment.clear();
+    segmentFrames = 0;
+}
+
+ReplayFile::ReplayFile(const std::string &path) {
+    int descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(descriptor < 0)
+        throw ReplayFileException("Could not open replay file " + path);
+    struct stat status;
+    if(fstat(descriptor, &status) == 0)
+        size = status.st_size;
+    if(size < REPLAY_HEADER_SIZE) {
+        close(descriptor);
+        throw ReplayFileException(path + " is not a replay file");
+    }
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if(mapping == MAP_FAILED)
+        throw ReplayFileException("Could not map replay file " + path);
+    data = static_cast<const uint8_t *>(mapping);
+
+    if(get32(data) != REPLAY_MAGIC || get16(data + 4) != REPLAY_VERSION
+        || data[6] > XOCHIP || data[7] > CHIP8_TRAP_LOG) {
+        munmap(const_cast<uint8_t *>(data), size);
+        throw ReplayFileException(path + " is not a replay file");
+    }
+    implementation = static_cast<CHIP8_IMPLEMENTATION>(data[6]);
+    trapPolicy = static_cast<CHIP8_TRAP_POLICY>(data[7]);
+    checkpointInterval = get32(data + 8);
+    if(!readIndex())
+        scanSegments();
+    if(segments.empty()) {
+        munmap(const_cast<uint8_t *>(data), size);
+        throw ReplayFileException(path + " holds no complete segment");
+    }
+}
+
+ReplayFile::~ReplayFile() {
+    munmap(const_cast<uint8_t *>(data), size);
+}
+
+bool ReplayFile::readIndex() {
+    if(size < REPLAY_HEADER_SIZE + REPLAY_TRAILER_SIZE)
+        return false;
+    auto trailer = data + size - REPLAY_TRAILER_SIZE;
+    if(get32(trailer + 12) != REPLAY_INDEX_MAGIC)
+        return false;
+    uint32_t count = get32(trailer);
+    uint64_t indexOffset = get64(trailer + 4);
+    if(indexOffset > size - REPLAY_TRAILER_SIZE
+        || (size - REPLAY_TRAILER_SIZE - indexOffset) / 12 < count)
+        return false;
+    for(uint32_t i = 0; i < count; ++i) {
+        uint64_t offset = get64(data + indexOffset + 12 * i + 4);
+        if(offset + REPLAY_SEGMENT_HEADER_SIZE > indexOffset)
+            return false;
+        auto header = data + offset;
+        ReplaySegment segment;
+        segment.firstFrame = get32(header + 4);
+        segment.frameCount = get32(header + 8);
+        segment.flags = get32(header + 12);
+        segment.stateSize = get32(header + 16);
+        segment.stateOffset = offset + REPLAY_SEGMENT_HEADER_SIZE;
+        segment.framesOffset = segment.stateOffset + segment.stateSize;
+        if(get32(header) != REPLAY_SEGMENT_MAGIC
+            || segment.framesOffset + uint64_t(segment.frameCount) * REPLAY_FRAME_SIZE > indexOffset) {
+            segments.clear();
+            return false;
+        }
+        segments.push_back(segment);
+    }
+    return true;
+}
+
+void ReplayFile::scanSegments() {
+    size_t offset = REPLAY_HEADER_SIZE;
+    while(offset + REPLAY_SEGMENT_HEADER_SIZE <= size) {
+        auto header = data + offset;
+        if(get32(header) != REPLAY_SEGMENT_MAGIC)
+            break;
+        ReplaySegment segment;
+        segment.firstFrame = get32(header + 4);
+        segment.frameCount = get32(header + 8);
+        segment.flags = get32(header + 12);
+        segment.stateSize = get32(header + 16);
+        segment.stateOffset = offset + REPLAY_SEGMENT_HEADER_SIZE;
+        segment.framesOffset = segment.stateOffset + segment.stateSize;
+        auto end = segment.framesOffset + uint64_t(segment.frameCount) * REPLAY_FRAME_SIZE;
+        if(end > size)
+            break;
+        segments.push_back(segment);
+        offset = end;
+    }
+}
+
+CHIP8_IMPLEMENTATION ReplayFile::getImplementation() const {
+    return implementation;
+}
+
+CHIP8_TRAP_POLICY ReplayFile::getTrapPolicy() const {
+    return trapPolicy;
+}
+
+unsigned int ReplayFile::getCheckpointInterval() const {
+    return checkpointInterval;
+}
+
+uint32_t ReplayFile::getFrameCount() const {
+    return segments.back().firstFrame + segments.back().frameCount;
+}
+
+const std::vector<ReplaySegment> &ReplayFile::getSegments() const {
+    return segments;
+}
+
+size_t ReplayFile::findSegment(uint32_t frame) const {
+    auto next = std::upper_bound(segments.begin(), segments.end(), frame,
+        [](uint32_t frame, const ReplaySegment &segment) { return frame < segment.firstFrame; });
+    return next == segments.begin() ? 0 : next - segments.begin() - 1;
+}
+
+ReplayFrame ReplayFile::getFrame(const ReplaySegment &segment, uint32_t frame) const {
+    auto record = data + segment.framesOffset + (frame - segment.firstFrame) * REPLAY_FRAME_SIZE;
+    return {get16(record), get32(record + 2)};
+}
+
+void ReplayFile::loadCheckpoint(const ReplaySegment &segment, Chip8 &chip8) const {
+    Chip8State state;
+    if(!deserializeState(data + segment.stateOffset, segment.stateSize, state)
+        || state.memory.size() != chip8.getMemorySize())
+        throw ReplayFileException("Corrupted checkpoint at frame " + std::to_string(segment.firstFrame));
+    chip8.restoreState(state);
+}
+
+// Mirrors Frame::runFrame: timers only tick when something ran or the
+// frame stalled
+void ReplayFile::playFrame(const ReplaySegment &segment, uint32_t frame,
+    Chip8 &chip8, Chip8Keyboard &keyboard) const {
+    auto recorded = getFrame(segment, frame);
+    applyKeyMask(keyboard, recorded.keys);
+    if(recorded.instructions == 0)
+        return;
+    if(recorded.instructions != REPLAY_FRAME_STALLED)
+        chip8.run(recorded.instructions);
+    chip8.tickTimers();
+}
+
+void ReplayFile::seek(Chip8 &chip8, Chip8Keyboard &keyboard, uint32_t frame) const {
+    auto &segment = segments[findSegment(frame)];
+    loadCheckpoint(segment, chip8);
+    auto last = std::min(frame, segment.firstFrame + segment.frameCount);
+    for(auto current = segment.firstFrame; current < last; ++current)
+        playFrame(segment, current, chip8, keyboard);
+}
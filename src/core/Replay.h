@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Chip8Factory.h"
+
+// Replay file layout, little endian:
+//   header   magic "C8RP", u16 version, u8 implementation, u8 trap policy,
+//            u32 checkpoint interval
+//   segment  magic "C8SG", u32 first frame, u32 frame count, u32 flags,
+//            u32 state size, checkpoint (state before the first frame), then
+//            per frame u16 keypad mask and u32 instructions executed
+//   index    per segment u32 first frame and u64 offset
+//   trailer  u32 segment count, u64 index offset, magic "C8IX"
+// A file without a trailer (the recorder did not finish) is indexed by
+// walking its segments instead.
+constexpr uint32_t REPLAY_MAGIC = 0x50523843;
+constexpr uint32_t REPLAY_SEGMENT_MAGIC = 0x47535843;
+constexpr uint32_t REPLAY_INDEX_MAGIC = 0x58493843;
+constexpr uint16_t REPLAY_VERSION = 1;
+constexpr size_t REPLAY_HEADER_SIZE = 12;
+constexpr size_t REPLAY_SEGMENT_HEADER_SIZE = 20;
+constexpr size_t REPLAY_FRAME_SIZE = 6;
+constexpr size_t REPLAY_TRAILER_SIZE = 16;
+constexpr unsigned int REPLAY_DEFAULT_CHECKPOINT_INTERVAL = 600;
+// The checkpoint does not follow from the previous segment (start, reload)
+constexpr uint32_t REPLAY_SEGMENT_RESET = 0x1;
+// Instructions of a frame that ran none but still ticked the timers, spent
+// finishing an instruction from an earlier frame under --cycle-timing
+constexpr uint32_t REPLAY_FRAME_STALLED = 0x80000000;
+
+class ReplayFileException: public std::runtime_error {
+    public:
+    ReplayFileException(const std::string &message):runtime_error(message){}
+};
+
+struct ReplayFrame {
+    uint16_t keys;
+    uint32_t instructions;
+};
+
+struct ReplaySegment {
+    uint32_t firstFrame;
+    uint32_t frameCount;
+    uint32_t flags;
+    // Offsets into the file
+    size_t stateOffset;
+    size_t stateSize;
+    size_t framesOffset;
+};
+
+void serializeState(const Chip8State &state, std::vector<uint8_t> &out);
+bool deserializeState(const uint8_t *data, size_t size, Chip8State &state);
+
+// Appends frames as they are played. Every checkpointInterval frames, or
+// when checkpoint() is called after a discontinuity such as a rom reload,
+// the pending segment is written and a new one starts with a snapshot.
+class ReplayWriter {
+    FILE *file;
+    unsigned int checkpointInterval;
+    std::vector<uint8_t> segment;
+    uint32_t segmentFirstFrame = 0;
+    uint32_t segmentFrames = 0;
+    uint32_t frame = 0;
+    uint64_t offset = 0;
+    std::vector<std::pair<uint32_t, uint64_t>> index;
+    Chip8State state;
+
+    void startSegment(const Chip8 &chip8, uint32_t flags);
+    void flushSegment();
+
+    public:
+    ReplayWriter(const std::string &path, CHIP8_IMPLEMENTATION impl, CHIP8_TRAP_POLICY trapPolicy,
+        const Chip8 &chip8, unsigned int checkpointInterval = REPLAY_DEFAULT_CHECKPOINT_INTERVAL);
+    ~ReplayWriter();
+    // Records a frame that just ran; chip8 is the state after it
+    void addFrame(const Chip8 &chip8, uint16_t keys, uint32_t instructions);
+    void checkpoint(const Chip8 &chip8);
+};
+
+// A replay mapped into memory. Seeking restores the nearest checkpoint and
+// replays at most one segment, and each segment can be replayed on its own,
+// so separate threads can work on different parts of one file.
+class ReplayFile {
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    CHIP8_IMPLEMENTATION implementation;
+    CHIP8_TRAP_POLICY trapPolicy;
+    unsigned int checkpointInterval;
+    std::vector<ReplaySegment> segments;
+
+    bool readIndex();
+    void scanSegments();
+
+    public:
+    ReplayFile(const std::string &path);
+    ~ReplayFile();
+    ReplayFile(const ReplayFile &) = delete;
+    ReplayFile &operator=(const ReplayFile &) = delete;
+
+    CHIP8_IMPLEMENTATION getImplementation() const;
+    CHIP8_TRAP_POLICY getTrapPolicy() const;
+    unsigned int getCheckpointInterval() const;
+    uint32_t getFrameCount() const;
+    const std::vector<ReplaySegment> &getSegments() const;
+    size_t findSegment(uint32_t frame) const;
+    ReplayFrame getFrame(const ReplaySegment &segment, uint32_t frame) const;
+    void loadCheckpoint(const ReplaySegment &segment, Chip8 &chip8) const;
+    // Runs one recorded frame on chip8
+    void playFrame(const ReplaySegment &segment, uint32_t frame,
+        Chip8 &chip8, Chip8Keyboard &keyboard) const;
+    // Leaves chip8 in the state before frame runs
+    void seek(Chip8 &chip8, Chip8Keyboard &keyboard, uint32_t frame) const;
+};
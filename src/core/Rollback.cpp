@@ -0,0 +1,147 @@
+#include "Rollback.h"
+#include <algorithm>
+
+namespace {
+
+void put16(std::vector<uint8_t> &out, uint16_t value) {
+    out.push_back(value & 0xFF);
+    out.push_back(value >> 8);
+}
+
+void put32(std::vector<uint8_t> &out, uint32_t value) {
+    put16(out, value & 0xFFFF);
+    put16(out, value >> 16);
+}
+
+uint16_t get16(const uint8_t *data) {
+    return data[0] | (data[1] << 8);
+}
+
+uint32_t get32(const uint8_t *data) {
+    return get16(data) | (uint32_t(get16(data + 2)) << 16);
+}
+
+}
+
+RollbackSession::RollbackSession(Chip8 &_chip8, Chip8Keyboard &_keyboard,
+    unsigned int _instructionsPerFrame):
+    chip8(_chip8),
+    keyboard(_keyboard),
+    instructionsPerFrame(_instructionsPerFrame) {
+    chip8.seedRandom(NETPLAY_RANDOM_SEED);
+}
+
+bool RollbackSession::canAdvance() const {
+    return currentFrame < remoteConfirmedUntil + ROLLBACK_WINDOW
+        && currentFrame < localAckedUntil + NETPLAY_INPUT_HISTORY;
+}
+
+bool RollbackSession::advance(uint16_t localKeys) {
+    if(!canAdvance())
+        return false;
+    auto &frame = history[currentFrame % ROLLBACK_WINDOW];
+    frame.localKeys = localKeys;
+    frame.remoteKeys = predictRemoteKeys(currentFrame);
+    localInputs[currentFrame % NETPLAY_INPUT_HISTORY] = localKeys;
+    chip8.saveState(frame.state);
+    simulate(frame);
+    ++currentFrame;
+    return true;
+}
+
+bool RollbackSession::hasPendingRollback() const {
+    return rollbackFrom.has_value();
+}
+
+// Replays from the earliest mispredicted frame; returns how many frames ran
+unsigned int RollbackSession::rollback() {
+    if(!rollbackFrom)
+        return 0;
+    auto first = rollbackFrom.value();
+    rollbackFrom.reset();
+    chip8.restoreState(history[first % ROLLBACK_WINDOW].state);
+    for(auto frameNumber = first; frameNumber < currentFrame; ++frameNumber) {
+        auto &frame = history[frameNumber % ROLLBACK_WINDOW];
+        if(frameNumber >= remoteConfirmedUntil)
+            frame.remoteKeys = predictRemoteKeys(frameNumber);
+        if(frameNumber != first)
+            chip8.saveState(frame.state);
+        simulate(frame);
+    }
+    ++rollbackCount;
+    replayedFrames += currentFrame - first;
+    return currentFrame - first;
+}
+
+void RollbackSession::simulate(RollbackFrame &frame) {
+    applyKeyMask(keyboard, frame.localKeys | frame.remoteKeys);
+    chip8.run(instructionsPerFrame);
+    chip8.tickTimers();
+}
+
+uint16_t RollbackSession::predictRemoteKeys(uint32_t frame) const {
+    auto &input = remoteInputs[frame % NETPLAY_INPUT_HISTORY];
+    if(input.valid && input.frame == frame)
+        return input.keys;
+    return lastRemoteKeys;
+}
+
+void RollbackSession::addRemoteInput(uint32_t frame, uint16_t keys) {
+    if(frame < remoteConfirmedUntil || frame >= remoteConfirmedUntil + NETPLAY_INPUT_HISTORY)
+        return;
+    remoteInputs[frame % NETPLAY_INPUT_HISTORY] = {frame, keys, true};
+    while(true) {
+        auto &next = remoteInputs[remoteConfirmedUntil % NETPLAY_INPUT_HISTORY];
+        if(!next.valid || next.frame != remoteConfirmedUntil)
+            break;
+        if(remoteConfirmedUntil < currentFrame) {
+            auto &past = history[remoteConfirmedUntil % ROLLBACK_WINDOW];
+            if(past.remoteKeys != next.keys) {
+                past.remoteKeys = next.keys;
+                if(!rollbackFrom)
+                    rollbackFrom = remoteConfirmedUntil;
+            }
+        }
+        lastRemoteKeys = next.keys;
+        ++remoteConfirmedUntil;
+    }
+}
+
+// Every packet repeats all local inputs the peer has not acknowledged yet,
+// so a lost datagram is covered by the next one.
+void RollbackSession::writePacket(std::vector<uint8_t> &packet) const {
+    uint32_t count = currentFrame - localAckedUntil;
+    packet.clear();
+    put32(packet, NETPLAY_PACKET_MAGIC);
+    put32(packet, localAckedUntil);
+    put32(packet, remoteConfirmedUntil);
+    packet.push_back(count);
+    for(uint32_t frame = localAckedUntil; frame < currentFrame; ++frame)
+        put16(packet, localInputs[frame % NETPLAY_INPUT_HISTORY]);
+}
+
+bool RollbackSession::readPacket(const uint8_t *data, size_t size) {
+    if(size < NETPLAY_PACKET_HEADER_SIZE || get32(data) != NETPLAY_PACKET_MAGIC)
+        return false;
+    uint32_t firstFrame = get32(data + 4);
+    uint32_t acknowledged = get32(data + 8);
+    uint8_t count = data[12];
+    if(count > NETPLAY_INPUT_HISTORY || size < NETPLAY_PACKET_HEADER_SIZE + 2 * count)
+        return false;
+    localAckedUntil = std::max(localAckedUntil, std::min(acknowledged, currentFrame));
+    for(uint8_t i = 0; i < count; ++i)
+        addRemoteInput(firstFrame + i, get16(data + NETPLAY_PACKET_HEADER_SIZE + 2 * i));
+    return true;
+}
+
+uint32_t RollbackSession::getFrame() const {
+    return currentFrame;
+}
+
+uint64_t RollbackSession::getRollbackCount() const {
+    return rollbackCount;
+}
+
+uint64_t RollbackSession::getReplayedFrames() const {
+    return replayedFrames;
+}
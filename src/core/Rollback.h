@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "Chip8.h"
+
+// Frames the local side may run ahead of the last confirmed remote input.
+constexpr unsigned int ROLLBACK_WINDOW = 16;
+constexpr unsigned int NETPLAY_INPUT_HISTORY = 2 * ROLLBACK_WINDOW;
+constexpr uint32_t NETPLAY_PACKET_MAGIC = 0x504E3843;
+constexpr size_t NETPLAY_PACKET_HEADER_SIZE = 13;
+constexpr size_t NETPLAY_MAX_PACKET_SIZE = NETPLAY_PACKET_HEADER_SIZE + 2 * NETPLAY_INPUT_HISTORY;
+// Both peers seed the core with this so CXNN rolls the same numbers.
+constexpr uint32_t NETPLAY_RANDOM_SEED = 0xC8C8;
+
+// Keys each player owns on the shared keypad: player one the left two
+// columns (1 2 4 5 7 8 A 0), player two the right two (3 C 6 D 9 E B F).
+constexpr uint16_t NETPLAY_PLAYER_KEYS[2] = {0x05B7, 0xFA48};
+
+struct RollbackFrame {
+    // State before the frame ran
+    Chip8State state;
+    uint16_t localKeys = 0;
+    uint16_t remoteKeys = 0;
+};
+
+struct RemoteInput {
+    uint32_t frame = 0;
+    uint16_t keys = 0;
+    bool valid = false;
+};
+
+// Keeps two peers running the same rom in step. Every frame runs at once
+// with the remote keys predicted from the last ones received; when the real
+// keys turn out different, the session restores the snapshot taken before
+// that frame and replays everything up to the present.
+class RollbackSession {
+    Chip8 &chip8;
+    Chip8Keyboard &keyboard;
+    unsigned int instructionsPerFrame;
+    std::array<RollbackFrame, ROLLBACK_WINDOW> history;
+    std::array<uint16_t, NETPLAY_INPUT_HISTORY> localInputs {};
+    std::array<RemoteInput, NETPLAY_INPUT_HISTORY> remoteInputs {};
+    uint32_t currentFrame = 0;
+    // Every remote input before this frame is known
+    uint32_t remoteConfirmedUntil = 0;
+    // The peer has every local input before this frame
+    uint32_t localAckedUntil = 0;
+    uint16_t lastRemoteKeys = 0;
+    std::optional<uint32_t> rollbackFrom;
+    uint64_t rollbackCount = 0;
+    uint64_t replayedFrames = 0;
+
+    void simulate(RollbackFrame &frame);
+    void addRemoteInput(uint32_t frame, uint16_t keys);
+    uint16_t predictRemoteKeys(uint32_t frame) const;
+
+    public:
+    RollbackSession(Chip8 &chip8, Chip8Keyboard &keyboard, unsigned int instructionsPerFrame);
+    bool canAdvance() const;
+    bool advance(uint16_t localKeys);
+    bool hasPendingRollback() const;
+    unsigned int rollback();
+    void writePacket(std::vector<uint8_t> &packet) const;
+    bool readPacket(const uint8_t *data, size_t size);
+    uint32_t getFrame() const;
+    uint64_t getRollbackCount() const;
+    uint64_t getReplayedFrames() const;
+};
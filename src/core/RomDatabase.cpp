@@ -0,0 +1,67 @@
+#include "RomDatabase.h"
+#include "Chip8Factory.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+struct RomDatabaseHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+}
+
+RomDatabase::RomDatabase(std::string filePath) {
+    auto file = fopen(filePath.c_str(), "rb");
+    if(file == nullptr) {
+        throw InvalidRomDatabaseException();
+    }
+    RomDatabaseHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1
+        && memcmp(header.magic, ROM_DATABASE_MAGIC, sizeof(header.magic)) == 0
+        && header.version == ROM_DATABASE_VERSION;
+    // The count must fit in the rest of the file before anything is allocated
+    long entriesStart = ftell(file);
+    valid = valid && fseek(file, 0, SEEK_END) == 0
+        && uint64_t(ftell(file) - entriesStart) / sizeof(RomDatabaseEntry) >= header.count
+        && fseek(file, entriesStart, SEEK_SET) == 0;
+    if(valid) {
+        entries.resize(header.count);
+        valid = fread(entries.data(), sizeof(RomDatabaseEntry), header.count, file) == header.count;
+    }
+    fclose(file);
+    valid = valid && std::all_of(entries.begin(), entries.end(),
+        [](const RomDatabaseEntry &entry) { return entry.implementation <= XOCHIP; });
+    if(!valid) {
+        throw InvalidRomDatabaseException();
+    }
+}
+
+std::optional<RomDatabaseEntry> RomDatabase::find(uint64_t hash) const {
+    auto entry = std::lower_bound(entries.begin(), entries.end(), hash,
+        [](const RomDatabaseEntry &entry, uint64_t hash) { return entry.hash < hash; });
+    if(entry == entries.end() || entry->hash != hash)
+        return std::nullopt;
+    return *entry;
+}
+
+void RomDatabase::write(std::string filePath, std::vector<RomDatabaseEntry> entries) {
+    std::sort(entries.begin(), entries.end(),
+        [](const RomDatabaseEntry &a, const RomDatabaseEntry &b) { return a.hash < b.hash; });
+    RomDatabaseHeader header {};
+    memcpy(header.magic, ROM_DATABASE_MAGIC, sizeof(header.magic));
+    header.version = ROM_DATABASE_VERSION;
+    header.count = entries.size();
+
+    auto file = fopen(filePath.c_str(), "wb");
+    if(file == nullptr) {
+        throw InvalidRomDatabaseException();
+    }
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(entries.data(), sizeof(RomDatabaseEntry), entries.size(), file);
+    fclose(file);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+constexpr char ROM_DATABASE_MAGIC[4] = {'C', '8', 'D', 'B'};
+constexpr uint32_t ROM_DATABASE_VERSION = 1;
+
+// On-disk record, stored little-endian and sorted by hash so the index can
+// be read with a single fread and searched in place.
+struct RomDatabaseEntry {
+    uint64_t hash;
+    uint8_t implementation;
+    uint8_t reserved;
+    uint16_t instructionsPerFrame;
+    // Keyboard key (lowercase ASCII) for each CHIP-8 key 0-F, 0 keeps the default.
+    char keyMapping[16];
+    uint8_t padding[4];
+};
+static_assert(sizeof(RomDatabaseEntry) == 32, "RomDatabaseEntry must match the index layout");
+
+class InvalidRomDatabaseException: public std::runtime_error {
+    public:
+    InvalidRomDatabaseException():runtime_error("Rom database does not exist or is corrupted"){}
+};
+
+class RomDatabase {
+    std::vector<RomDatabaseEntry> entries;
+
+    public:
+    RomDatabase(std::string filePath);
+    std::optional<RomDatabaseEntry> find(uint64_t hash) const;
+    static void write(std::string filePath, std::vector<RomDatabaseEntry> entries);
+};
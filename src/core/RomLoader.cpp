@@ -0,0 +1,37 @@
+#include "RomLoader.h"
+#include <cstdio>
+#include "Hash.h"
+
+RomImage RomLoader::load(std::string filePath) {
+    auto file = fopen(filePath.c_str(), "rb");
+    if(file == nullptr) {
+        throw InvalidFileException();
+    }
+    RomImage rom;
+    rom.data.resize(XOCHIP_MAX_PROGRAM_SIZE);
+    rom.size = fread(rom.data.data(), 1, rom.data.size(), file);
+    bool tooLarge = rom.size == rom.data.size() && fgetc(file) != EOF;
+    bool failed = ferror(file);
+    fclose(file);
+    if(tooLarge) {
+        throw RomFileTooLargeException();
+    }
+    if(failed) {
+        throw InvalidFileException();
+    }
+    rom.data.resize(rom.size);
+    rom.hash = hash(rom.data.data(), rom.size);
+    return rom;
+}
+
+void RomLoader::checkFits(const RomImage &rom, CHIP8_IMPLEMENTATION impl) {
+    auto maxSize = Chip8Factory::getMaxProgramSize(impl);
+    if(rom.size > maxSize) {
+        throw RomFileTooLargeException("Rom is " + std::to_string(rom.size) + " bytes, "
+            + Chip8Factory::toName(impl) + " mode fits at most " + std::to_string(maxSize));
+    }
+}
+
+uint64_t RomLoader::hash(const char *data, size_t size) {
+    return fnv1a(data, size);
+}
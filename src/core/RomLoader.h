@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include "Chip8Factory.h"
+
+typedef std::vector<char> Chip8Rom;
+
+class RomFileTooLargeException: public std::runtime_error {
+    public:
+    RomFileTooLargeException():runtime_error("Rom file exceeded max size"){}
+    RomFileTooLargeException(const std::string &message):runtime_error(message){}
+};
+
+class InvalidFileException: public std::runtime_error {
+    public:
+    InvalidFileException():runtime_error("File does not exist or is corrupted"){}
+};
+
+struct RomImage {
+    Chip8Rom data;
+    size_t size = 0;
+    uint64_t hash = 0;
+};
+
+class RomLoader {
+    public:
+    static RomImage load(std::string filePath);
+    // Roms are read up to the largest memory; this checks the chosen one
+    static void checkFits(const RomImage &rom, CHIP8_IMPLEMENTATION impl);
+    static uint64_t hash(const char *data, size_t size);
+};
@@ -1,6 +1,6 @@
 #include "SChip.h"
 
-SChip::SChip(const Chip8Keyboard &keyboard): Chip8(keyboard) {}
+SChip::SChip(const Chip8Keyboard &keyboard, size_t memorySize): Chip8(keyboard, memorySize) {}
 
 void SChip::shiftRight(uint16_t instruction) {
     auto vx = getXRegister(instruction);
@@ -26,7 +26,7 @@ void SChip::storeRegistersToMemory(uint16_t instruction) {
     auto x = getXIdx(instruction);
     auto temporaryI = indexPointer;
     for(uint8_t i = 0; i <= x; ++i, ++temporaryI) {
-        memory[temporaryI] = variables[i];
+        writeMemory(temporaryI, variables[i]);
     }
 }
 
@@ -34,7 +34,7 @@ void SChip::loadRegistersFromMemory(uint16_t instruction) {
     auto x = getXIdx(instruction);
     auto temporaryI = indexPointer;
     for(uint8_t i = 0; i <= x; ++i, ++temporaryI) {
-        variables[i] = memory[temporaryI];
+        variables[i] = readMemory(temporaryI);
     }
 }
 
@@ -54,4 +54,80 @@ void SChip::logicalXor(uint16_t instruction) {
     auto vx = getXRegister(instruction);
     auto vyValue = getYRegister(instruction);
     setXRegister(instruction, vx ^ vyValue);
-}
\ No newline at end of file
+}
+
+void SChip::zeroCategoryHandler(uint16_t instruction) {
+    if((instruction & 0xFFF0) == 0x00C0) {
+        display->scrollDown(instruction & 0x000F);
+        return;
+    }
+
+    switch(instruction) {
+        case 0x00FB:
+            display->scrollRight(4);
+            break;
+        case 0x00FC:
+            display->scrollLeft(4);
+            break;
+        case 0x00FD:
+            // There is no host to return to, so exit halts on itself
+            programCounter -= 2;
+            break;
+        case 0x00FE:
+            display->setHighResolution(false);
+            break;
+        case 0x00FF:
+            display->setHighResolution(true);
+            break;
+        default:
+            Chip8::zeroCategoryHandler(instruction);
+            break;
+    }
+}
+
+void SChip::draw(uint16_t instruction) {
+    if((instruction & 0x000F) != 0) {
+        Chip8::draw(instruction);
+        return;
+    }
+
+    int vx = getXRegister(instruction) % display->getWidth();
+    int vy = getYRegister(instruction) % display->getHeight();
+    variables[0xF] = display->drawSprite(vx, vy, loadSprite(32), 16);
+}
+
+void SChip::fCategoryHandler(uint16_t instruction) {
+    switch(instruction & 0x00FF) {
+        case 0x30:
+            getBigFontCharacter(instruction);
+            break;
+        case 0x75:
+            storePersistentFlags(instruction);
+            break;
+        case 0x85:
+            loadPersistentFlags(instruction);
+            break;
+        default:
+            Chip8::fCategoryHandler(instruction);
+            break;
+    }
+}
+
+void SChip::getBigFontCharacter(uint16_t instruction) {
+    auto vxValue = getXRegister(instruction) & 0x0F;
+    indexPointer = CHIP8_BIG_FONT_BEGINNING_ADDRESS + 10 * vxValue;
+}
+
+void SChip::storePersistentFlags(uint16_t instruction) {
+    auto x = getXIdx(instruction);
+    for(int i = 0; i <= x; ++i) {
+        persistentFlags[i] = variables[i];
+    }
+}
+
+void SChip::loadPersistentFlags(uint16_t instruction) {
+    auto x = getXIdx(instruction);
+    for(int i = 0; i <= x; ++i) {
+        variables[i] = persistentFlags[i];
+    }
+}
@@ -2,6 +2,7 @@
 #include "Chip8.h"
 
 class SChip: public Chip8 {
+    protected:
     void shiftRight(uint16_t);
     void shiftLeft(uint16_t);
     void jumpWithOffset(uint16_t);
@@ -10,6 +11,12 @@ class SChip: public Chip8 {
     void binaryOr(uint16_t instruction);
     void binaryAnd(uint16_t instruction);
     void logicalXor(uint16_t instruction);
+    void zeroCategoryHandler(uint16_t instruction);
+    void draw(uint16_t instruction);
+    void fCategoryHandler(uint16_t instruction);
+    void getBigFontCharacter(uint16_t instruction);
+    void storePersistentFlags(uint16_t instruction);
+    void loadPersistentFlags(uint16_t instruction);
     public:
-    SChip(const Chip8Keyboard &keyboard);
+    SChip(const Chip8Keyboard &keyboard, size_t memorySize = CHIP8_MEMORY_SIZE);
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include "Display.h"
+#include "SpscRing.h"
+
+// Layout of the shared memory segment an emulator publishes with --shm.
+// Consumers map it read-write, check magic and version, read snapshots
+// with readSharedSnapshot and push key events into the input ring.
+constexpr uint32_t SHARED_STATE_MAGIC = 0x4D533843; // "C8SM"
+constexpr uint32_t SHARED_STATE_VERSION = 2;
+constexpr unsigned int SHARED_INPUT_CAPACITY = 256;
+constexpr unsigned int SHARED_WATCH_COUNT = 16;
+constexpr unsigned int SHARED_WATCH_NAME_LENGTH = 16;
+
+// A named memory or register location, see MemorySearch
+struct SharedWatch {
+    char name[SHARED_WATCH_NAME_LENGTH];
+    uint32_t location;
+    uint8_t value;
+};
+
+struct SharedSnapshot {
+    uint64_t frame;
+    uint64_t cycleCount;
+    uint16_t programCounter;
+    uint16_t indexPointer;
+    uint8_t variables[16];
+    uint8_t stackDepth;
+    uint8_t halted;
+    uint16_t keyMask;
+    uint8_t watchCount;
+    SharedWatch watches[SHARED_WATCH_COUNT];
+    PixelMatrix display;
+};
+
+struct SharedKeyEvent {
+    uint8_t key;
+    uint8_t pressed;
+};
+
+struct SharedStateSegment {
+    uint32_t magic;
+    uint32_t version;
+    // Odd while the emulator is writing the snapshot
+    alignas(64) std::atomic<uint64_t> sequence {0};
+    SharedSnapshot snapshot;
+    // Written by one consumer, drained by the emulator once per frame
+    SpscRing<SharedKeyEvent, SHARED_INPUT_CAPACITY> input;
+};
+
+inline void writeSharedSnapshot(SharedStateSegment &segment, const SharedSnapshot &snapshot) {
+    auto sequence = segment.sequence.load(std::memory_order_relaxed);
+    segment.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&segment.snapshot, &snapshot, sizeof(snapshot));
+    segment.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// Returns false when the emulator was writing, callers retry or use the
+// previous frame; the emulator never waits for readers.
+inline bool readSharedSnapshot(const SharedStateSegment &segment, SharedSnapshot &snapshot) {
+    auto before = segment.sequence.load(std::memory_order_acquire);
+    if(before & 1)
+        return false;
+    memcpy(&snapshot, &segment.snapshot, sizeof(snapshot));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return segment.sequence.load(std::memory_order_relaxed) == before;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Fixed-capacity single producer, single consumer queue. Neither side
+// blocks or allocates, so it is safe to use from audio callbacks.
+template<typename T, size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    std::array<T, Capacity> items;
+    alignas(64) std::atomic<size_t> head {0};
+    alignas(64) std::atomic<size_t> tail {0};
+
+    public:
+    bool push(const T &item) {
+        auto currentHead = head.load(std::memory_order_relaxed);
+        if(currentHead - tail.load(std::memory_order_acquire) == Capacity)
+            return false;
+        items[currentHead & (Capacity - 1)] = item;
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    const T *peek() const {
+        auto currentTail = tail.load(std::memory_order_relaxed);
+        if(currentTail == head.load(std::memory_order_acquire))
+            return nullptr;
+        return &items[currentTail & (Capacity - 1)];
+    }
+
+    void pop() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+};
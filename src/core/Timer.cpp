@@ -1,26 +1,19 @@
 #include "Timer.h"
 
-Timer::Timer():
-    start(Clock::now()),
-    givenTime(std::chrono::nanoseconds(0)) {}
-
-void Timer::startTimer() {
-    start = Clock::now();
+void Timer::setValue(uint8_t _value) {
+    value = _value;
 }
 
-void Timer::setTime(Clock::duration time) {
-    givenTime = time;
+uint8_t Timer::getValue() const {
+    return value;
 }
 
-std::chrono::steady_clock::duration Timer::getStatus() {
-    auto timeLeft = givenTime - (Clock::now() - start);
-    if(timeLeft < std::chrono::nanoseconds(0)) {
-        return Clock::duration(0);
+void Timer::tick() {
+    if(value > 0) {
+        --value;
     }
-    return timeLeft;
 }
 
-bool Timer::hasFinished() {
-    return getStatus() == Clock::duration(0);
+bool Timer::hasFinished() const {
+    return value == 0;
 }
-
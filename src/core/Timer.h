@@ -1,15 +1,14 @@
 #pragma once
-#include <chrono>
-
-typedef std::chrono::steady_clock Clock;
+#include <cstdint>
 
+// Counts down at CHIP8_TIMER_FREQUENCY, one tick() per 60 Hz frame. Driven by
+// the host instead of the wall clock so two instances fed the same frames
+// stay in lockstep.
 class Timer {
-    Clock::time_point start;
-    Clock::duration givenTime;
+    uint8_t value = 0;
     public:
-    Timer();
-    void startTimer();
-    bool hasFinished();
-    void setTime(Clock::duration time);
-    std::chrono::steady_clock::duration getStatus();
-};
\ No newline at end of file
+    void setValue(uint8_t value);
+    uint8_t getValue() const;
+    void tick();
+    bool hasFinished() const;
+};
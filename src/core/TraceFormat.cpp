@@ -0,0 +1,129 @@
+#include "TraceFormat.h"
+
+namespace {
+
+enum COMPRESSED_RECORD_FLAGS {
+    SEQUENTIAL_PC = 0x01,
+    SAME_INDEX = 0x02,
+    SAME_VF = 0x04,
+    NO_CHANGES = 0x08
+};
+
+void put16(std::vector<uint8_t> &out, uint16_t value) {
+    out.push_back(value & 0xFF);
+    out.push_back(value >> 8);
+}
+
+void put32(std::vector<uint8_t> &out, uint32_t value) {
+    put16(out, value & 0xFFFF);
+    put16(out, value >> 16);
+}
+
+uint16_t get16(const uint8_t *&data, const uint8_t *end) {
+    if(end - data < 2)
+        throw CorruptedTraceException();
+    uint16_t value = data[0] | (data[1] << 8);
+    data += 2;
+    return value;
+}
+
+uint8_t get8(const uint8_t *&data, const uint8_t *end) {
+    if(data >= end)
+        throw CorruptedTraceException();
+    return *data++;
+}
+
+void putChangedValues(std::vector<uint8_t> &out, const TraceRecord &record) {
+    for(int i = 0; i < 0xF; ++i) {
+        if(record.changedRegisters & (1 << i))
+            out.push_back(record.variables[i]);
+    }
+}
+
+const uint8_t *getChangedValues(const uint8_t *data, const uint8_t *end, TraceRecord &record) {
+    for(int i = 0; i < 0xF; ++i) {
+        if(record.changedRegisters & (1 << i))
+            record.variables[i] = get8(data, end);
+    }
+    return data;
+}
+
+}
+
+TraceEncoder::TraceEncoder(bool _compressed): compressed(_compressed) {}
+
+void TraceEncoder::encode(const TraceRecord &record, std::vector<uint8_t> &out) {
+    if(!compressed) {
+        put16(out, record.programCounter);
+        put16(out, record.opcode);
+        put16(out, record.indexPointer);
+        out.push_back(record.variables[0xF]);
+        put16(out, record.changedRegisters);
+        putChangedValues(out, record);
+        return;
+    }
+
+    uint8_t flags = 0;
+    if(record.programCounter == (uint16_t)(previous.programCounter + 2))
+        flags |= SEQUENTIAL_PC;
+    if(record.indexPointer == previous.indexPointer)
+        flags |= SAME_INDEX;
+    if(record.variables[0xF] == previous.variables[0xF])
+        flags |= SAME_VF;
+    if(record.changedRegisters == 0)
+        flags |= NO_CHANGES;
+
+    out.push_back(flags);
+    put16(out, record.opcode);
+    if(!(flags & SEQUENTIAL_PC))
+        put16(out, record.programCounter);
+    if(!(flags & SAME_INDEX))
+        put16(out, record.indexPointer);
+    if(!(flags & SAME_VF))
+        out.push_back(record.variables[0xF]);
+    if(!(flags & NO_CHANGES)) {
+        put16(out, record.changedRegisters);
+        putChangedValues(out, record);
+    }
+    previous = record;
+}
+
+TraceDecoder::TraceDecoder(bool _compressed): compressed(_compressed) {}
+
+const uint8_t *TraceDecoder::decode(const uint8_t *data, const uint8_t *end, TraceRecord &record) {
+    record = previous;
+    if(!compressed) {
+        record.programCounter = get16(data, end);
+        record.opcode = get16(data, end);
+        record.indexPointer = get16(data, end);
+        record.variables[0xF] = get8(data, end);
+        record.changedRegisters = get16(data, end);
+    } else {
+        uint8_t flags = get8(data, end);
+        record.opcode = get16(data, end);
+        record.programCounter = (flags & SEQUENTIAL_PC)
+            ? previous.programCounter + 2
+            : get16(data, end);
+        if(!(flags & SAME_INDEX))
+            record.indexPointer = get16(data, end);
+        if(!(flags & SAME_VF))
+            record.variables[0xF] = get8(data, end);
+        record.changedRegisters = (flags & NO_CHANGES) ? 0 : get16(data, end);
+    }
+    data = getChangedValues(data, end, record);
+    previous = record;
+    return data;
+}
+
+void writeTraceHeader(std::vector<uint8_t> &out, uint16_t flags) {
+    out.insert(out.end(), TRACE_MAGIC, TRACE_MAGIC + sizeof(TRACE_MAGIC));
+    put16(out, TRACE_VERSION);
+    put16(out, flags);
+}
+
+void writeTraceBlockHeader(std::vector<uint8_t> &out,
+    uint16_t stream, uint32_t recordCount, uint32_t payloadSize) {
+    put16(out, stream);
+    put32(out, recordCount);
+    put32(out, payloadSize);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <stdexcept>
+
+constexpr char TRACE_MAGIC[4] = {'C', '8', 'T', 'R'};
+constexpr uint16_t TRACE_VERSION = 1;
+constexpr uint16_t TRACE_FLAG_COMPRESSED = 0x0001;
+constexpr unsigned int TRACE_HEADER_SIZE = 8;
+constexpr unsigned int TRACE_BLOCK_HEADER_SIZE = 10;
+
+struct TraceRecord {
+    uint16_t programCounter;
+    uint16_t opcode;
+    uint16_t indexPointer;
+    uint16_t changedRegisters;
+    uint8_t variables[16];
+};
+
+class CorruptedTraceException: public std::runtime_error {
+    public:
+    CorruptedTraceException():runtime_error("Trace file is corrupted or truncated"){}
+};
+
+// Raw records are: PC, opcode, I, VF, changed register mask, new values of
+// changed V0-VE. Compressed records start with a flag byte and omit the PC
+// when it advanced by 2 and I, VF or the mask when they did not change.
+class TraceEncoder {
+    bool compressed;
+    TraceRecord previous {};
+
+    public:
+    TraceEncoder(bool compressed);
+    void encode(const TraceRecord &record, std::vector<uint8_t> &out);
+};
+
+class TraceDecoder {
+    bool compressed;
+    TraceRecord previous {};
+
+    public:
+    TraceDecoder(bool compressed);
+    const uint8_t *decode(const uint8_t *data, const uint8_t *end, TraceRecord &record);
+};
+
+void writeTraceHeader(std::vector<uint8_t> &out, uint16_t flags);
+void writeTraceBlockHeader(std::vector<uint8_t> &out,
+    uint16_t stream, uint32_t recordCount, uint32_t payloadSize);
@@ -0,0 +1,91 @@
+#include "TraceWriter.h"
+#include <chrono>
+#include <algorithm>
+
+namespace {
+constexpr size_t TRACE_RING_MASK = TRACE_RING_CAPACITY - 1;
+constexpr size_t TRACE_BLOCK_RECORDS = 4096;
+}
+
+TraceRing::TraceRing():
+    records(std::make_unique<TraceRecord[]>(TRACE_RING_CAPACITY)) {}
+
+void TraceRing::push(const TraceRecord &record) {
+    auto currentHead = head.load(std::memory_order_relaxed);
+    if(currentHead - cachedTail == TRACE_RING_CAPACITY) {
+        cachedTail = tail.load(std::memory_order_acquire);
+        while(currentHead - cachedTail == TRACE_RING_CAPACITY) {
+            std::this_thread::yield();
+            cachedTail = tail.load(std::memory_order_acquire);
+        }
+    }
+    records[currentHead & TRACE_RING_MASK] = record;
+    head.store(currentHead + 1, std::memory_order_release);
+}
+
+size_t TraceRing::drain(std::vector<TraceRecord> &out, size_t maxRecords) {
+    auto currentTail = tail.load(std::memory_order_relaxed);
+    auto available = head.load(std::memory_order_acquire) - currentTail;
+    auto count = std::min(available, maxRecords);
+    for(size_t i = 0; i < count; ++i) {
+        out.push_back(records[(currentTail + i) & TRACE_RING_MASK]);
+    }
+    tail.store(currentTail + count, std::memory_order_release);
+    return count;
+}
+
+TraceWriter::TraceWriter(std::string path, bool _compressed):
+    file(fopen(path.c_str(), "wb")),
+    compressed(_compressed) {
+    if(file == nullptr) {
+        throw TraceFileException();
+    }
+    std::vector<uint8_t> header;
+    writeTraceHeader(header, compressed ? TRACE_FLAG_COMPRESSED : 0);
+    fwrite(header.data(), 1, header.size(), file);
+    worker = std::thread(&TraceWriter::writerLoop, this);
+}
+
+TraceWriter::~TraceWriter() {
+    running = false;
+    worker.join();
+    fclose(file);
+}
+
+TraceRing *TraceWriter::registerProducer() {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    rings.push_back(std::make_unique<TraceRing>());
+    encoders.emplace_back(compressed);
+    return rings.back().get();
+}
+
+void TraceWriter::writerLoop() {
+    while(running.load()) {
+        if(drainRings() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    while(drainRings() > 0) {}
+    fflush(file);
+}
+
+size_t TraceWriter::drainRings() {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    std::vector<uint8_t> blockHeader;
+    size_t drained = 0;
+    for(uint16_t stream = 0; stream < rings.size(); ++stream) {
+        batch.clear();
+        payload.clear();
+        blockHeader.clear();
+        if(rings[stream]->drain(batch, TRACE_BLOCK_RECORDS) == 0)
+            continue;
+        for(auto &record: batch) {
+            encoders[stream].encode(record, payload);
+        }
+        writeTraceBlockHeader(blockHeader, stream, batch.size(), payload.size());
+        fwrite(blockHeader.data(), 1, blockHeader.size(), file);
+        fwrite(payload.data(), 1, payload.size(), file);
+        drained += batch.size();
+    }
+    return drained;
+}
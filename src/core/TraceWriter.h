@@ -0,0 +1,50 @@
+#pragma once
+#include "TraceFormat.h"
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr unsigned int TRACE_RING_CAPACITY = 1 << 16;
+
+class TraceFileException: public std::runtime_error {
+    public:
+    TraceFileException():runtime_error("Could not open trace file for writing"){}
+};
+
+// Single producer, single consumer ring. The emulation thread owning the
+// ring pushes, the writer thread drains.
+class TraceRing {
+    std::unique_ptr<TraceRecord[]> records;
+    alignas(64) std::atomic<size_t> head {0};
+    size_t cachedTail = 0;
+    alignas(64) std::atomic<size_t> tail {0};
+
+    public:
+    TraceRing();
+    void push(const TraceRecord &record);
+    size_t drain(std::vector<TraceRecord> &out, size_t maxRecords);
+};
+
+class TraceWriter {
+    FILE *file;
+    bool compressed;
+    std::mutex ringsMutex;
+    std::vector<std::unique_ptr<TraceRing>> rings;
+    std::vector<TraceEncoder> encoders;
+    std::vector<TraceRecord> batch;
+    std::vector<uint8_t> payload;
+    std::atomic<bool> running {true};
+    std::thread worker;
+
+    void writerLoop();
+    size_t drainRings();
+
+    public:
+    TraceWriter(std::string path, bool compressed);
+    ~TraceWriter();
+    TraceRing *registerProducer();
+};
@@ -0,0 +1,130 @@
+#include "XOChip.h"
+
+XOChip::XOChip(const Chip8Keyboard &keyboard): SChip(keyboard, XOCHIP_MEMORY_SIZE) {
+    display->setWrapping(true);
+}
+
+void XOChip::shiftRight(uint16_t instruction) {
+    auto vy = getYRegister(instruction);
+    auto shiftedBit = vy & 0x01;
+    setXRegister(instruction, vy >> 1);
+    variables[0xF] = shiftedBit;
+}
+
+void XOChip::shiftLeft(uint16_t instruction) {
+    auto vy = getYRegister(instruction);
+    auto shiftedBit = (vy & 0x80) >> 7;
+    setXRegister(instruction, vy << 1);
+    variables[0xF] = shiftedBit;
+}
+
+void XOChip::jumpWithOffset(uint16_t instruction) {
+    uint16_t address = instruction & 0x0FFF;
+    address += variables[0x0];
+    programCounter = address;
+}
+
+void XOChip::storeRegistersToMemory(uint16_t instruction) {
+    auto x = getXIdx(instruction);
+    for(uint8_t i = 0; i <= x; ++i, ++indexPointer) {
+        writeMemory(indexPointer, variables[i]);
+    }
+}
+
+void XOChip::loadRegistersFromMemory(uint16_t instruction) {
+    auto x = getXIdx(instruction);
+    for(uint8_t i = 0; i <= x; ++i, ++indexPointer) {
+        variables[i] = readMemory(indexPointer);
+    }
+}
+
+// F000 NNNN is four bytes long, so skips have to step over its address too
+void XOChip::skipNextInstruction() {
+    bool longInstruction = programCounter + 1u < memory.size()
+        && memory[programCounter] == 0xF0 && memory[programCounter + 1] == 0x00;
+    programCounter += longInstruction ? 4 : 2;
+}
+
+void XOChip::skipEqualRegisters(uint16_t instruction) {
+    switch(instruction & 0x000F) {
+        case 0x0:
+            Chip8::skipEqualRegisters(instruction);
+            break;
+        case 0x2:
+            storeRegisterRange(instruction);
+            break;
+        case 0x3:
+            loadRegisterRange(instruction);
+            break;
+        default:
+            raiseTrap(CHIP8_FAULT_INVALID_OPCODE);
+            break;
+    }
+}
+
+void XOChip::storeRegisterRange(uint16_t instruction) {
+    int x = getXIdx(instruction);
+    int y = getYIdx(instruction);
+    int step = x <= y ? 1 : -1;
+    uint16_t address = indexPointer;
+    for(int i = x; ; i += step, ++address) {
+        writeMemory(address, variables[i]);
+        if(i == y)
+            break;
+    }
+}
+
+void XOChip::loadRegisterRange(uint16_t instruction) {
+    int x = getXIdx(instruction);
+    int y = getYIdx(instruction);
+    int step = x <= y ? 1 : -1;
+    uint16_t address = indexPointer;
+    for(int i = x; ; i += step, ++address) {
+        variables[i] = readMemory(address);
+        if(i == y)
+            break;
+    }
+}
+
+void XOChip::zeroCategoryHandler(uint16_t instruction) {
+    if((instruction & 0xFFF0) == 0x00D0) {
+        display->scrollUp(instruction & 0x000F);
+        return;
+    }
+    SChip::zeroCategoryHandler(instruction);
+}
+
+void XOChip::draw(uint16_t instruction) {
+    int vx = getXRegister(instruction) % display->getWidth();
+    int vy = getYRegister(instruction) % display->getHeight();
+    int height = instruction & 0x000F;
+    int spriteWidth = height == 0 ? 16 : 8;
+    int spriteBytes = height == 0 ? 32 : height;
+    auto sprite = loadSprite(spriteBytes * display->getSelectedPlaneCount());
+    variables[0xF] = display->drawSprite(vx, vy, sprite, spriteWidth);
+}
+
+void XOChip::fCategoryHandler(uint16_t instruction) {
+    if(instruction == 0xF000) {
+        loadLongIndex();
+        return;
+    }
+
+    switch(instruction & 0x00FF) {
+        case 0x01:
+            display->selectPlanes(getXIdx(instruction));
+            break;
+        case 0x02:
+        case 0x3A:
+            // Audio pattern and pitch; the buzzer only plays a square wave
+            break;
+        default:
+            SChip::fCategoryHandler(instruction);
+            break;
+    }
+}
+
+void XOChip::loadLongIndex() {
+    indexPointer = fetchInstruction();
+    programCounter += 2;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "SChip.h"
+
+class XOChip: public SChip {
+    void shiftRight(uint16_t);
+    void shiftLeft(uint16_t);
+    void jumpWithOffset(uint16_t);
+    void storeRegistersToMemory(uint16_t);
+    void loadRegistersFromMemory(uint16_t);
+    void skipNextInstruction();
+    void skipEqualRegisters(uint16_t instruction);
+    void zeroCategoryHandler(uint16_t instruction);
+    void draw(uint16_t instruction);
+    void fCategoryHandler(uint16_t instruction);
+    void storeRegisterRange(uint16_t instruction);
+    void loadRegisterRange(uint16_t instruction);
+    void loadLongIndex();
+    public:
+    XOChip(const Chip8Keyboard &keyboard);
+};
@@ -3,6 +3,30 @@
 #include <argparse/argparse.hpp>
 #include <memory>
 #include "Frame.h"
+#include "core/RomDatabase.h"
+
+#define DEFAULT_ROM_DATABASE_PATH "roms.c8db"
+
+std::optional<RomDatabaseEntry> findRomSettings(argparse::ArgumentParser &parser, uint64_t romHash) {
+    try {
+        RomDatabase database(parser.get("--romdb"));
+        return database.find(romHash);
+    } catch(InvalidRomDatabaseException &e) {
+        if(parser.is_used("--romdb"))
+            std::cout << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+CHIP8_TRAP_POLICY parseTrapPolicy(const std::string &name) {
+    if(name == "halt")
+        return CHIP8_TRAP_HALT;
+    if(name == "skip")
+        return CHIP8_TRAP_SKIP;
+    if(name == "log")
+        return CHIP8_TRAP_LOG;
+    throw std::runtime_error("unknown trap policy " + name);
+}
 
 int main(int argc, char *argv[]) {
 
@@ -15,6 +39,54 @@ int main(int argc, char *argv[]) {
         .help("path to chip8 rom file");
     parser.add_argument("-c", "--compatibility")
         .help("extensions compatibility mode");
+    parser.add_argument("--ipf")
+        .help("instructions executed per 60 Hz frame")
+        .scan<'i', int>();
+    parser.add_argument("--run-ahead")
+        .help("show the screen this many frames ahead to hide a game's input lag (0-8)")
+        .default_value(0u)
+        .scan<'u', unsigned int>();
+    parser.add_argument("--romdb")
+        .help("rom database with per-rom compatibility mode, speed and keys")
+        .default_value(std::string(DEFAULT_ROM_DATABASE_PATH));
+    parser.add_argument("-w", "--watch")
+        .help("reload the rom in place whenever the file changes")
+        .default_value(false)
+        .implicit_value(true);
+    parser.add_argument("--watch-replay")
+        .help("after a reload, replay the input recorded since start")
+        .default_value(false)
+        .implicit_value(true);
+    parser.add_argument("--trace")
+        .help("record every executed instruction to a binary trace file");
+    parser.add_argument("--trace-compress")
+        .help("delta-encode trace records")
+        .default_value(false)
+        .implicit_value(true);
+    parser.add_argument("--capture")
+        .help("record the screen to a .gif, .png (animated) or .y4m file");
+    parser.add_argument("--record")
+        .help("record a seekable replay of the session, see chip8-replay");
+    parser.add_argument("--shm")
+        .help("publish screen, registers and keypad to this POSIX shared memory name");
+    parser.add_argument("--netplay")
+        .help("two-player rollback netplay: LOCAL PEER addresses, host:port or unix:/path")
+        .nargs(2);
+    parser.add_argument("--player")
+        .help("netplay player, 1 (left half of the keypad) or 2 (right half)")
+        .default_value(1)
+        .scan<'i', int>();
+    parser.add_argument("--cycle-timing")
+        .help("run frames for the implementation's cycle budget instead of --ipf instructions")
+        .default_value(false)
+        .implicit_value(true);
+    parser.add_argument("--on-trap")
+        .help("what to do when the rom faults: halt, skip or log")
+        .default_value(std::string("log"));
+    parser.add_argument("-d", "--debug")
+        .help("read debugger commands (breakpoints, watchpoints) from stdin")
+        .default_value(false)
+        .implicit_value(true);
 
     try {
         parser.parse_args(argc, argv);
@@ -23,18 +95,68 @@ int main(int argc, char *argv[]) {
         std::cerr << parser;
         std::exit(1);
     }
-    auto compatibilityMode = CHIP8_IMPLEMENTATION::ORIGINAL_CHIP8;
-    if(auto compatibility = parser.present("-c")) {
-        if(compatibility.value() == "schip") {
-            compatibilityMode = CHIP8_IMPLEMENTATION::SCHIP;
-            std::cout << "Running with SUPER-CHIP 1.0 compatibility" << std::endl;
-        }
-    }
-
     auto romFilePath = parser.get("file");
     std::unique_ptr<Frame> frame;
     try {
-        frame = std::make_unique<Frame>(romFilePath, compatibilityMode);
+        auto rom = RomLoader::load(romFilePath);
+        auto romSettings = findRomSettings(parser, rom.hash);
+
+        auto compatibilityMode = CHIP8_IMPLEMENTATION::ORIGINAL_CHIP8;
+        if(auto compatibility = parser.present("-c")) {
+            if(auto implementation = Chip8Factory::fromName(compatibility.value())) {
+                compatibilityMode = implementation.value();
+            }
+        } else if(romSettings) {
+            compatibilityMode = static_cast<CHIP8_IMPLEMENTATION>(romSettings->implementation);
+        }
+        if(compatibilityMode == CHIP8_IMPLEMENTATION::SCHIP) {
+            std::cout << "Running with SUPER-CHIP 1.0 compatibility" << std::endl;
+        } else if(compatibilityMode == CHIP8_IMPLEMENTATION::XOCHIP) {
+            std::cout << "Running with XO-CHIP compatibility" << std::endl;
+        }
+
+        frame = std::make_unique<Frame>(rom, compatibilityMode);
+        if(auto instructionsPerFrame = parser.present<int>("--ipf")) {
+            frame->setInstructionsPerFrame(instructionsPerFrame.value());
+        } else if(romSettings && romSettings->instructionsPerFrame > 0) {
+            frame->setInstructionsPerFrame(romSettings->instructionsPerFrame);
+        }
+        if(romSettings) {
+            frame->setKeyMapping(romSettings->keyMapping);
+        }
+        frame->setTrapPolicy(parseTrapPolicy(parser.get("--on-trap")));
+        frame->setRunAhead(parser.get<unsigned int>("--run-ahead"));
+        if(parser.get<bool>("--cycle-timing")) {
+            if(parser.present("--netplay"))
+                throw std::runtime_error("--cycle-timing cannot be combined with --netplay");
+            frame->enableCycleTiming();
+        }
+        if(auto traceFilePath = parser.present("--trace")) {
+            frame->enableTrace(traceFilePath.value(), parser.get<bool>("--trace-compress"));
+        }
+        if(auto captureFilePath = parser.present("--capture")) {
+            frame->enableCapture(captureFilePath.value());
+        }
+        if(auto sharedStateName = parser.present("--shm")) {
+            frame->enableSharedState(sharedStateName.value());
+        }
+        if(auto netplayAddresses = parser.present<std::vector<std::string>>("--netplay")) {
+            if(parser.present("--record"))
+                throw std::runtime_error("--record cannot be combined with --netplay");
+            if(parser.get<bool>("--watch") || parser.get<bool>("--watch-replay"))
+                throw std::runtime_error("--watch cannot be combined with --netplay");
+            frame->enableNetplay(parser.get<int>("--player"),
+                netplayAddresses->at(0), netplayAddresses->at(1));
+        }
+        if(auto replayFilePath = parser.present("--record")) {
+            frame->enableReplay(replayFilePath.value());
+        }
+        if(parser.get<bool>("--watch") || parser.get<bool>("--watch-replay")) {
+            frame->enableWatch(romFilePath, parser.get<bool>("--watch-replay"));
+        }
+        if(parser.get<bool>("--debug")) {
+            frame->enableDebugger();
+        }
     } catch(std::runtime_error &e) {
         std::cout << e.what() << std::endl;
         std::exit(1);
@@ -0,0 +1,85 @@
+#include "PerformanceOverlay.h"
+#include <imgui.h>
+#include <imgui_impl_sdl2.h>
+#include <imgui_impl_sdlrenderer2.h>
+#include <cstdio>
+
+PerformanceOverlay::PerformanceOverlay(SDL_Window *window, SDL_Renderer *_renderer):
+    renderer(_renderer) {
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGui::GetIO().IniFilename = nullptr;
+    ImGui::StyleColorsDark();
+    ImGui_ImplSDL2_InitForSDLRenderer(window, renderer);
+    ImGui_ImplSDLRenderer2_Init(renderer);
+}
+
+PerformanceOverlay::~PerformanceOverlay() {
+    ImGui_ImplSDLRenderer2_Shutdown();
+    ImGui_ImplSDL2_Shutdown();
+    ImGui::DestroyContext();
+}
+
+bool PerformanceOverlay::processEvent(const SDL_Event &e) {
+    if(e.type == SDL_KEYDOWN && !e.key.repeat
+        && e.key.keysym.scancode == PERFORMANCE_OVERLAY_HOTKEY) {
+        visible = !visible;
+        return true;
+    }
+    if(visible) {
+        ImGui_ImplSDL2_ProcessEvent(&e);
+    }
+    return false;
+}
+
+void PerformanceOverlay::draw(const PerformanceStats &stats) {
+    if(!visible)
+        return;
+
+    ImGui_ImplSDLRenderer2_NewFrame();
+    ImGui_ImplSDL2_NewFrame();
+    ImGui::NewFrame();
+
+    ImGui::SetNextWindowPos(ImVec2(8, 8), ImGuiCond_Always);
+    ImGui::SetNextWindowBgAlpha(0.75f);
+    ImGui::Begin("Performance", nullptr,
+        ImGuiWindowFlags_NoDecoration
+        | ImGuiWindowFlags_AlwaysAutoResize
+        | ImGuiWindowFlags_NoSavedSettings
+        | ImGuiWindowFlags_NoFocusOnAppearing
+        | ImGuiWindowFlags_NoNav);
+
+    ImGui::Text("Guest: %.0f instructions/s", stats.getInstructionsPerSecond());
+    if(stats.getGuestLoad() >= 0)
+        ImGui::Text("Guest load: %.1f%% of cycle budget", stats.getGuestLoad());
+    ImGui::Text("Frame: %.2f ms (emulation %.2f ms, render %.2f ms)",
+        stats.getFrameTime(),
+        stats.getEmulationTime(),
+        stats.getRenderTime());
+    ImGui::Text("Sleep overshoot: %.2f ms", stats.getSleepOvershoot());
+    ImGui::Text("Idle: %.1f%%", stats.getIdlePercentage());
+
+    char label[32];
+    snprintf(label, sizeof(label), "%.2f ms", stats.getFrameTime());
+    ImGui::PlotHistogram("##frameTimes",
+        stats.getFrameTimes().data(),
+        stats.getFrameTimes().size(),
+        stats.getHistoryOffset(),
+        label,
+        0.0f,
+        1000.0f / 60,
+        ImVec2(240, 60));
+    ImGui::Text("Bound: %s", describeBottleneck(stats));
+
+    ImGui::End();
+    ImGui::Render();
+    ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData(), renderer);
+}
+
+const char *PerformanceOverlay::describeBottleneck(const PerformanceStats &stats) const {
+    if(stats.getIdlePercentage() > 50.0f)
+        return "idle";
+    if(stats.getEmulationTime() >= stats.getRenderTime())
+        return "CPU (emulation)";
+    return "render";
+}
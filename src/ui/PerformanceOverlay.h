@@ -0,0 +1,18 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include "PerformanceStats.h"
+
+#define PERFORMANCE_OVERLAY_HOTKEY SDL_SCANCODE_F1
+
+class PerformanceOverlay {
+    SDL_Renderer *renderer;
+    bool visible = false;
+
+    const char *describeBottleneck(const PerformanceStats &stats) const;
+
+    public:
+    PerformanceOverlay(SDL_Window *window, SDL_Renderer *renderer);
+    ~PerformanceOverlay();
+    bool processEvent(const SDL_Event &e);
+    void draw(const PerformanceStats &stats);
+};
@@ -0,0 +1,88 @@
+#include "PerformanceStats.h"
+#include <algorithm>
+
+void PerformanceStats::recordFrame(uint64_t instructions,
+    Clock::duration emulationTime,
+    Clock::duration renderTime,
+    Clock::duration busyTime,
+    Clock::duration sleepTime,
+    Clock::duration sleepOvershoot) {
+    lastFrameTime = toMilliseconds(busyTime);
+    lastEmulationTime = toMilliseconds(emulationTime);
+    lastRenderTime = toMilliseconds(renderTime);
+    lastSleepOvershoot = toMilliseconds(sleepOvershoot);
+
+    frameTimes[historyIdx] = lastFrameTime;
+    historyIdx = (historyIdx + 1) % PERFORMANCE_HISTORY_LENGTH;
+
+    windowInstructions += instructions;
+    windowIdle += sleepTime;
+    windowLength += busyTime + sleepTime;
+
+    auto now = Clock::now();
+    if(now - windowStart >= std::chrono::seconds(1)) {
+        closeWindow(now);
+    }
+}
+
+void PerformanceStats::recordGuestLoad(uint32_t cycles, uint32_t budget) {
+    windowCycles += std::min(cycles, budget);
+    windowBudget += budget;
+}
+
+void PerformanceStats::closeWindow(Clock::time_point now) {
+    std::chrono::duration<float> elapsed = now - windowStart;
+    instructionsPerSecond = windowInstructions / elapsed.count();
+    if(windowLength.count() > 0) {
+        idlePercentage = 100.0f * windowIdle.count() / windowLength.count();
+    }
+    if(windowBudget > 0) {
+        guestLoad = 100.0f * windowCycles / windowBudget;
+    }
+    windowStart = now;
+    windowInstructions = 0;
+    windowCycles = 0;
+    windowBudget = 0;
+    windowIdle = Clock::duration(0);
+    windowLength = Clock::duration(0);
+}
+
+float PerformanceStats::toMilliseconds(Clock::duration duration) {
+    return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+const std::array<float, PERFORMANCE_HISTORY_LENGTH> &PerformanceStats::getFrameTimes() const {
+    return frameTimes;
+}
+
+unsigned int PerformanceStats::getHistoryOffset() const {
+    return historyIdx;
+}
+
+float PerformanceStats::getInstructionsPerSecond() const {
+    return instructionsPerSecond;
+}
+
+float PerformanceStats::getIdlePercentage() const {
+    return idlePercentage;
+}
+
+float PerformanceStats::getGuestLoad() const {
+    return guestLoad;
+}
+
+float PerformanceStats::getFrameTime() const {
+    return lastFrameTime;
+}
+
+float PerformanceStats::getEmulationTime() const {
+    return lastEmulationTime;
+}
+
+float PerformanceStats::getRenderTime() const {
+    return lastRenderTime;
+}
+
+float PerformanceStats::getSleepOvershoot() const {
+    return lastSleepOvershoot;
+}
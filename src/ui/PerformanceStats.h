@@ -0,0 +1,53 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+constexpr unsigned int PERFORMANCE_HISTORY_LENGTH = 120;
+
+class PerformanceStats {
+    typedef std::chrono::steady_clock Clock;
+
+    std::array<float, PERFORMANCE_HISTORY_LENGTH> frameTimes {};
+    unsigned int historyIdx = 0;
+
+    Clock::time_point windowStart = Clock::now();
+    uint64_t windowInstructions = 0;
+    uint64_t windowCycles = 0;
+    uint64_t windowBudget = 0;
+    Clock::duration windowIdle {};
+    Clock::duration windowLength {};
+
+    float instructionsPerSecond = 0;
+    float idlePercentage = 0;
+    float guestLoad = -1;
+    float lastFrameTime = 0;
+    float lastEmulationTime = 0;
+    float lastRenderTime = 0;
+    float lastSleepOvershoot = 0;
+
+    static float toMilliseconds(Clock::duration duration);
+    void closeWindow(Clock::time_point now);
+
+    public:
+    void recordFrame(uint64_t instructions,
+        Clock::duration emulationTime,
+        Clock::duration renderTime,
+        Clock::duration busyTime,
+        Clock::duration sleepTime,
+        Clock::duration sleepOvershoot);
+
+    // Cycles the guest used out of its frame budget, with --cycle-timing
+    void recordGuestLoad(uint32_t cycles, uint32_t budget);
+
+    const std::array<float, PERFORMANCE_HISTORY_LENGTH> &getFrameTimes() const;
+    unsigned int getHistoryOffset() const;
+    float getInstructionsPerSecond() const;
+    float getIdlePercentage() const;
+    // Percentage of the cycle budget used, negative without one
+    float getGuestLoad() const;
+    float getFrameTime() const;
+    float getEmulationTime() const;
+    float getRenderTime() const;
+    float getSleepOvershoot() const;
+};
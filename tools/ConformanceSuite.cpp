@@ -0,0 +1,51 @@
+#include "ConformanceSuite.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "core/Hash.h"
+
+ConformanceSuite::ConformanceSuite(const ConformanceSettings &_settings):
+    settings(_settings) {
+    settings.checkpointInterval = std::max(settings.checkpointInterval, 1u);
+}
+
+std::vector<std::vector<ConformanceCheckpoint>> ConformanceSuite::run(
+    const std::vector<ConformanceJob> &jobs, unsigned int threadCount) const {
+    std::vector<std::vector<ConformanceCheckpoint>> results(jobs.size());
+    std::atomic<size_t> nextJob {0};
+    auto worker = [&]() {
+        for(size_t job = nextJob++; job < jobs.size(); job = nextJob++)
+            results[job] = runJob(jobs[job]);
+    };
+    threadCount = std::max(1u, std::min<unsigned int>(threadCount, jobs.size()));
+    std::vector<std::thread> threads;
+    for(unsigned int i = 1; i < threadCount; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for(auto &thread: threads)
+        thread.join();
+    return results;
+}
+
+std::vector<ConformanceCheckpoint> ConformanceSuite::runJob(const ConformanceJob &job) const {
+    Chip8Keyboard keyboard {};
+    auto chip8 = Chip8Factory::make(job.implementation, keyboard);
+    chip8->seedRandom(CONFORMANCE_RANDOM_SEED);
+    chip8->setTrapPolicy(CHIP8_TRAP_SKIP);
+    chip8->loadRom(job.rom.data(), job.rom.size());
+
+    std::vector<ConformanceCheckpoint> checkpoints;
+    for(unsigned int frame = 1; frame <= settings.frames; ++frame) {
+        applyKeyMask(keyboard, frame <= job.keys.size() ? job.keys[frame - 1] : 0);
+        chip8->run(settings.instructionsPerFrame);
+        chip8->tickTimers();
+        if(frame % settings.checkpointInterval == 0)
+            checkpoints.push_back({frame, hashFramebuffer(chip8->peek())});
+    }
+    return checkpoints;
+}
+
+uint64_t hashFramebuffer(const PixelMatrix &pixels) {
+    uint64_t hash = fnv1a(&pixels.highResolution, sizeof(pixels.highResolution));
+    return fnv1a(pixels.planes.data(), sizeof(pixels.planes), hash);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "core/Chip8Factory.h"
+
+constexpr uint32_t CONFORMANCE_RANDOM_SEED = 0xC8C8C8C8;
+
+struct ConformanceJob {
+    std::string romName;
+    std::vector<uint8_t> rom;
+    // Keypad state per frame; every key is released once the script ends
+    std::vector<uint16_t> keys;
+    CHIP8_IMPLEMENTATION implementation;
+};
+
+struct ConformanceCheckpoint {
+    unsigned int frame;
+    uint64_t hash;
+};
+
+struct ConformanceSettings {
+    unsigned int frames = 600;
+    unsigned int checkpointInterval = 60;
+    unsigned int instructionsPerFrame = 30;
+};
+
+// Runs roms headless for a fixed number of frames and hashes the
+// framebuffer every checkpointInterval frames. Jobs are independent, each
+// on its own core instance, and are spread over a pool of threads.
+class ConformanceSuite {
+    ConformanceSettings settings;
+
+    std::vector<ConformanceCheckpoint> runJob(const ConformanceJob &job) const;
+
+    public:
+    ConformanceSuite(const ConformanceSettings &settings);
+    std::vector<std::vector<ConformanceCheckpoint>> run(
+        const std::vector<ConformanceJob> &jobs, unsigned int threadCount) const;
+};
+
+uint64_t hashFramebuffer(const PixelMatrix &pixels);
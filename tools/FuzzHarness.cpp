@@ -0,0 +1,141 @@
+#include "FuzzHarness.h"
+#include <cstdio>
+#include <algorithm>
+
+FuzzHarness::FuzzHarness(CHIP8_IMPLEMENTATION impl,
+    unsigned int _instructionsPerCase,
+    unsigned int _instructionsPerFrame):
+    chip8(Chip8Factory::make(impl, keyboard)),
+    instructionsPerCase(_instructionsPerCase),
+    instructionsPerFrame(std::max(_instructionsPerFrame, 1u)) {
+    chip8->seedRandom(0);
+    chip8->setTrapPolicy(CHIP8_TRAP_HALT);
+    chip8->saveState(initialState);
+}
+
+FuzzResult FuzzHarness::run(const FuzzCase &fuzzCase) {
+    FuzzResult result;
+    chip8->restoreState(initialState);
+    chip8->loadRom(fuzzCase.rom.data(), fuzzCase.rom.size());
+    keyboard.fill(false);
+
+    uint16_t previousProgramCounter = 0;
+    for(unsigned int i = 0; i < instructionsPerCase; ++i) {
+        if(i % instructionsPerFrame == 0) {
+            auto frame = i / instructionsPerFrame;
+            if(frame > 0)
+                chip8->tickTimers();
+            if(!fuzzCase.keys.empty())
+                applyKeyMask(keyboard, fuzzCase.keys[frame % fuzzCase.keys.size()]);
+        }
+
+        auto programCounter = chip8->getProgramCounter();
+        uint16_t opcode = (chip8->peekMemory(programCounter) << 8)
+            | chip8->peekMemory(programCounter + 1);
+        result.newCoverage |= recordCoverage(previousProgramCounter, programCounter, opcode);
+        previousProgramCounter = programCounter;
+
+        chip8->doNextCycle();
+        if(chip8->isHalted()) {
+            result.finding = toFinding(chip8->getLastTrap());
+            return result;
+        }
+    }
+    return result;
+}
+
+bool FuzzHarness::recordCoverage(uint16_t previousProgramCounter,
+    uint16_t programCounter, uint16_t opcode) {
+    bool newCoverage = false;
+    auto edge = ((previousProgramCounter << 4) ^ programCounter) % FUZZ_EDGE_MAP_SIZE;
+    if(!edges[edge]) {
+        edges.set(edge);
+        newCoverage = true;
+    }
+    if(!programCounters[programCounter]) {
+        programCounters.set(programCounter);
+        ++programCounterCount;
+    }
+    auto opcodeClass = classifyOpcode(opcode);
+    if(!opcodeClasses[opcodeClass]) {
+        opcodeClasses.set(opcodeClass);
+        ++opcodeClassCount;
+        newCoverage = true;
+    }
+    return newCoverage;
+}
+
+// Invalid opcodes end the case without a finding, the mutator produces
+// too many of them for each to be interesting
+std::optional<FuzzFinding> FuzzHarness::toFinding(const Chip8Trap &trap) const {
+    FindingKind kind;
+    switch(trap.fault) {
+        case CHIP8_FAULT_READ_OUT_OF_BOUNDS:
+            kind = FindingKind::OUT_OF_BOUNDS_READ;
+            break;
+        case CHIP8_FAULT_WRITE_OUT_OF_BOUNDS:
+            kind = FindingKind::OUT_OF_BOUNDS_WRITE;
+            break;
+        case CHIP8_FAULT_FETCH_OUT_OF_BOUNDS:
+            kind = FindingKind::OUT_OF_BOUNDS_FETCH;
+            break;
+        case CHIP8_FAULT_STACK_OVERFLOW:
+            kind = FindingKind::STACK_OVERFLOW;
+            break;
+        case CHIP8_FAULT_STACK_UNDERFLOW:
+            kind = FindingKind::STACK_UNDERFLOW;
+            break;
+        case CHIP8_FAULT_INVALID_KEY:
+            kind = FindingKind::INVALID_KEY;
+            break;
+        default:
+            return std::nullopt;
+    }
+    std::string description = describeFault(trap.fault);
+    if(kind == FindingKind::OUT_OF_BOUNDS_READ || kind == FindingKind::OUT_OF_BOUNDS_WRITE) {
+        char indexPointer[16];
+        snprintf(indexPointer, sizeof(indexPointer), " at I=%04X", chip8->getIndexPointer());
+        description += indexPointer;
+    }
+    return FuzzFinding {kind, trap.programCounter, trap.opcode, description};
+}
+
+size_t FuzzHarness::getProgramCounterCoverage() const {
+    return programCounterCount;
+}
+
+size_t FuzzHarness::getOpcodeCoverage() const {
+    return opcodeClassCount;
+}
+
+uint16_t classifyOpcode(uint16_t opcode) {
+    switch(opcode & 0xF000) {
+        case 0x0000:
+            return opcode == 0x00E0 || opcode == 0x00EE ? opcode : 0x0000;
+        case 0x8000:
+            return opcode & 0xF00F;
+        case 0xE000:
+        case 0xF000:
+            return opcode & 0xF0FF;
+        default:
+            return opcode & 0xF000;
+    }
+}
+
+const char *describeFindingKind(FindingKind kind) {
+    switch(kind) {
+        case FindingKind::OUT_OF_BOUNDS_READ:
+            return "oob-read";
+        case FindingKind::OUT_OF_BOUNDS_WRITE:
+            return "oob-write";
+        case FindingKind::OUT_OF_BOUNDS_FETCH:
+            return "oob-fetch";
+        case FindingKind::STACK_OVERFLOW:
+            return "stack-overflow";
+        case FindingKind::STACK_UNDERFLOW:
+            return "stack-underflow";
+        case FindingKind::INVALID_KEY:
+            return "invalid-key";
+    }
+    return "unknown";
+}
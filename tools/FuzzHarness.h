@@ -0,0 +1,67 @@
+#pragma once
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "core/Chip8Factory.h"
+
+constexpr unsigned int FUZZ_EDGE_MAP_SIZE = 1 << 16;
+
+struct FuzzCase {
+    std::vector<uint8_t> rom;
+    std::vector<uint16_t> keys;
+};
+
+enum class FindingKind {
+    OUT_OF_BOUNDS_READ,
+    OUT_OF_BOUNDS_WRITE,
+    OUT_OF_BOUNDS_FETCH,
+    STACK_OVERFLOW,
+    STACK_UNDERFLOW,
+    INVALID_KEY
+};
+
+struct FuzzFinding {
+    FindingKind kind;
+    uint16_t programCounter;
+    uint16_t opcode;
+    std::string description;
+};
+
+struct FuzzResult {
+    bool newCoverage = false;
+    std::optional<FuzzFinding> finding;
+};
+
+// Runs fuzz cases against a single Chip8 instance, restoring it from a
+// snapshot instead of constructing a new one per case. The core halts on its
+// first trap, which becomes the case's finding.
+class FuzzHarness {
+    Chip8Keyboard keyboard {};
+    std::unique_ptr<Chip8> chip8;
+    Chip8State initialState;
+    unsigned int instructionsPerCase;
+    unsigned int instructionsPerFrame;
+
+    std::bitset<FUZZ_EDGE_MAP_SIZE> edges;
+    std::bitset<XOCHIP_MEMORY_SIZE> programCounters;
+    std::bitset<1 << 16> opcodeClasses;
+    size_t programCounterCount = 0;
+    size_t opcodeClassCount = 0;
+
+    std::optional<FuzzFinding> toFinding(const Chip8Trap &trap) const;
+    bool recordCoverage(uint16_t previousProgramCounter, uint16_t programCounter, uint16_t opcode);
+
+    public:
+    FuzzHarness(CHIP8_IMPLEMENTATION impl,
+        unsigned int instructionsPerCase,
+        unsigned int instructionsPerFrame);
+    FuzzResult run(const FuzzCase &fuzzCase);
+    size_t getProgramCounterCoverage() const;
+    size_t getOpcodeCoverage() const;
+};
+
+const char *describeFindingKind(FindingKind kind);
+uint16_t classifyOpcode(uint16_t opcode);
@@ -0,0 +1,129 @@
+#include "RomMutator.h"
+#include <algorithm>
+#include "core/Chip8.h"
+
+namespace {
+
+constexpr uint8_t EIGHT_CATEGORY_SELECTORS[] = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE};
+constexpr uint8_t F_CATEGORY_SELECTORS[] = {0x07, 0x0A, 0x15, 0x18, 0x1E, 0x29, 0x33, 0x55, 0x65};
+
+}
+
+RomMutator::RomMutator(uint64_t seed, size_t _maxRomSize, size_t _frames):
+    random(seed),
+    maxRomSize(std::max<size_t>(_maxRomSize & ~1, 2)),
+    frames(std::max<size_t>(_frames, 1)) {}
+
+FuzzCase RomMutator::generate() {
+    FuzzCase fuzzCase;
+    auto romSize = 2 + 2 * (random() % (maxRomSize / 2));
+    fuzzCase.rom.resize(romSize);
+    for(size_t offset = 0; offset < romSize; offset += 2) {
+        putInstruction(fuzzCase.rom, offset, randomInstruction(romSize));
+    }
+    fuzzCase.keys.resize(frames);
+    for(auto &keys: fuzzCase.keys) {
+        keys = random() % 4 == 0 ? 1 << (random() % 16) : 0;
+    }
+    return fuzzCase;
+}
+
+FuzzCase RomMutator::mutate(const FuzzCase &parent, const std::vector<FuzzCase> &corpus) {
+    FuzzCase child = parent;
+    if(child.rom.size() < 2)
+        child.rom.resize(2);
+    auto mutations = 1 + random() % 4;
+    for(unsigned int i = 0; i < mutations; ++i) {
+        if(random() % 8 == 0)
+            mutateKeys(child.keys);
+        else
+            mutateRom(child.rom, corpus);
+    }
+    return child;
+}
+
+void RomMutator::mutateRom(std::vector<uint8_t> &rom, const std::vector<FuzzCase> &corpus) {
+    switch(random() % 7) {
+        case 0:
+            rom[random() % rom.size()] ^= 1 << (random() % 8);
+            break;
+        case 1:
+            rom[random() % rom.size()] = random();
+            break;
+        case 2:
+            putInstruction(rom, randomInstructionOffset(rom), randomInstruction(rom.size()));
+            break;
+        case 3:
+            if(rom.size() + 2 <= maxRomSize) {
+                auto offset = randomInstructionOffset(rom);
+                rom.insert(rom.begin() + offset, 2, 0);
+                putInstruction(rom, offset, randomInstruction(rom.size()));
+            }
+            break;
+        case 4:
+            if(rom.size() > 2) {
+                auto offset = randomInstructionOffset(rom);
+                rom.erase(rom.begin() + offset, rom.begin() + std::min(offset + 2, rom.size()));
+            }
+            break;
+        case 5: {
+            auto &other = corpus[random() % corpus.size()].rom;
+            if(other.empty())
+                break;
+            auto from = random() % other.size();
+            auto length = std::min<size_t>(1 + random() % 16, other.size() - from);
+            auto to = random() % rom.size();
+            length = std::min(length, rom.size() - to);
+            std::copy(other.begin() + from, other.begin() + from + length, rom.begin() + to);
+            break;
+        }
+        case 6: {
+            auto offset = randomInstructionOffset(rom);
+            uint16_t target = CHIP8_PROGRAM_BEGINNING_ADDRESS + randomInstructionOffset(rom);
+            uint16_t category = random() % 2 ? 0x1000 : 0x2000;
+            putInstruction(rom, offset, category | target);
+            break;
+        }
+    }
+}
+
+void RomMutator::mutateKeys(std::vector<uint16_t> &keys) {
+    if(keys.empty())
+        keys.resize(frames);
+    auto &frameKeys = keys[random() % keys.size()];
+    frameKeys ^= 1 << (random() % 16);
+}
+
+uint16_t RomMutator::randomInstruction(size_t romSize) {
+    uint16_t category = random() % 16;
+    uint16_t operands = random() & 0x0FFF;
+    switch(category) {
+        case 0x0:
+            return random() % 2 ? 0x00E0 : 0x00EE;
+        case 0x1:
+        case 0x2:
+            return (category << 12)
+                | (CHIP8_PROGRAM_BEGINNING_ADDRESS + 2 * (random() % (romSize / 2)));
+        case 0x8:
+            return 0x8000 | (operands & 0x0FF0)
+                | EIGHT_CATEGORY_SELECTORS[random() % sizeof(EIGHT_CATEGORY_SELECTORS)];
+        case 0xE:
+            return 0xE000 | (operands & 0x0F00) | (random() % 2 ? 0x9E : 0xA1);
+        case 0xF:
+            return 0xF000 | (operands & 0x0F00)
+                | F_CATEGORY_SELECTORS[random() % sizeof(F_CATEGORY_SELECTORS)];
+        default:
+            return (category << 12) | operands;
+    }
+}
+
+void RomMutator::putInstruction(std::vector<uint8_t> &rom, size_t offset, uint16_t instruction) {
+    if(offset + 1 >= rom.size())
+        return;
+    rom[offset] = instruction >> 8;
+    rom[offset + 1] = instruction & 0xFF;
+}
+
+size_t RomMutator::randomInstructionOffset(const std::vector<uint8_t> &rom) {
+    return 2 * (random() % std::max<size_t>(rom.size() / 2, 1));
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "FuzzHarness.h"
+
+class RomMutator {
+    std::mt19937_64 random;
+    size_t maxRomSize;
+    size_t frames;
+
+    uint16_t randomInstruction(size_t romSize);
+    void putInstruction(std::vector<uint8_t> &rom, size_t offset, uint16_t instruction);
+    size_t randomInstructionOffset(const std::vector<uint8_t> &rom);
+    void mutateRom(std::vector<uint8_t> &rom, const std::vector<FuzzCase> &corpus);
+    void mutateKeys(std::vector<uint16_t> &keys);
+
+    public:
+    RomMutator(uint64_t seed, size_t maxRomSize, size_t frames);
+    FuzzCase generate();
+    FuzzCase mutate(const FuzzCase &parent, const std::vector<FuzzCase> &corpus);
+};
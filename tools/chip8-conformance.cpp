@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <argparse/argparse.hpp>
+#include "ConformanceSuite.h"
+#include "core/RomLoader.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// Golden file format, # starts a comment:
+//   settings <frames> <checkpoint interval> <instructions per frame>
+//   <rom file name> <compatibility> <frame> <16 digit hex framebuffer hash>
+struct GoldenValues {
+    ConformanceSettings settings;
+    std::map<std::pair<std::string, std::string>, std::map<unsigned int, uint64_t>> hashes;
+};
+
+GoldenValues readGolden(const std::string &path) {
+    GoldenValues golden;
+    std::ifstream file(path);
+    if(!file)
+        throw std::runtime_error("could not read " + path + ", record it with --update");
+    std::string line;
+    for(int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        if(line.empty() || line[0] == '#')
+            continue;
+        std::istringstream fields(line);
+        std::string rom, compatibility, hash;
+        unsigned int frame = 0;
+        fields >> rom;
+        if(rom == "settings") {
+            fields >> golden.settings.frames >> golden.settings.checkpointInterval
+                >> golden.settings.instructionsPerFrame;
+        } else if(fields >> compatibility >> frame >> hash) {
+            golden.hashes[{rom, compatibility}][frame] = std::stoull(hash, nullptr, 16);
+        }
+        if(!fields)
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": malformed line");
+    }
+    return golden;
+}
+
+void writeGolden(const std::string &path, const GoldenValues &golden) {
+    std::ofstream file(path);
+    file << "# written by chip8-conformance --update\n";
+    file << "settings " << golden.settings.frames << " " << golden.settings.checkpointInterval
+        << " " << golden.settings.instructionsPerFrame << "\n";
+    char hash[17];
+    for(auto &run: golden.hashes) {
+        for(auto &checkpoint: run.second) {
+            snprintf(hash, sizeof(hash), "%016" PRIx64, checkpoint.second);
+            file << run.first.first << " " << run.first.second
+                << " " << checkpoint.first << " " << hash << "\n";
+        }
+    }
+    if(!file)
+        throw std::runtime_error("could not write " + path);
+}
+
+// Runs of the implementations that were not selected are kept, so updating
+// one implementation leaves the golden values of the others in place. They
+// were recorded with the file's settings, which then have to stay the same.
+void mergeGolden(GoldenValues &golden, const std::string &path,
+    const std::vector<CHIP8_IMPLEMENTATION> &implementations) {
+    if(!std::filesystem::exists(path))
+        return;
+    auto recorded = readGolden(path);
+    for(auto &run: recorded.hashes) {
+        auto implementation = Chip8Factory::fromName(run.first.second);
+        if(implementation && std::find(implementations.begin(), implementations.end(),
+            implementation.value()) != implementations.end())
+            continue;
+        if(recorded.settings.frames != golden.settings.frames
+            || recorded.settings.checkpointInterval != golden.settings.checkpointInterval
+            || recorded.settings.instructionsPerFrame != golden.settings.instructionsPerFrame)
+            throw std::runtime_error(path + " was recorded with other settings, "
+                "update every implementation in it to change them");
+        golden.hashes.insert(run);
+    }
+}
+
+// Keys use the .keys format written by chip8-fuzz: one little endian
+// keypad mask per frame.
+std::vector<uint16_t> loadKeys(const std::filesystem::path &path) {
+    std::vector<uint16_t> keys;
+    std::ifstream file(path, std::ios::binary);
+    char frameKeys[2];
+    while(file.read(frameKeys, sizeof(frameKeys)))
+        keys.push_back(uint8_t(frameKeys[0]) | uint8_t(frameKeys[1]) << 8);
+    return keys;
+}
+
+std::vector<ConformanceJob> collectJobs(const std::string &directory,
+    const std::string &goldenPath, const std::vector<CHIP8_IMPLEMENTATION> &implementations) {
+    std::vector<std::filesystem::path> romPaths;
+    std::error_code error;
+    for(auto &entry: std::filesystem::directory_iterator(directory)) {
+        if(!entry.is_regular_file() || entry.path().extension() == ".keys"
+            || std::filesystem::equivalent(entry.path(), goldenPath, error))
+            continue;
+        romPaths.push_back(entry.path());
+    }
+    std::sort(romPaths.begin(), romPaths.end());
+
+    std::vector<ConformanceJob> jobs;
+    for(auto &romPath: romPaths) {
+        RomImage rom;
+        try {
+            rom = RomLoader::load(romPath.string());
+        } catch(std::runtime_error &e) {
+            std::cout << romPath.string() << ": " << e.what() << std::endl;
+            continue;
+        }
+        auto keysPath = romPath;
+        keysPath += ".keys";
+        auto keys = loadKeys(keysPath);
+        for(auto implementation: implementations) {
+            try {
+                RomLoader::checkFits(rom, implementation);
+            } catch(std::runtime_error &e) {
+                std::cout << romPath.string() << ": " << e.what() << std::endl;
+                continue;
+            }
+            jobs.push_back({romPath.filename().string(),
+                std::vector<uint8_t>(rom.data.begin(), rom.data.begin() + rom.size),
+                keys, implementation});
+        }
+    }
+    return jobs;
+}
+
+int main(int argc, char *argv[]) {
+    argparse::ArgumentParser parser("chip8-conformance",
+        "0.1",
+        argparse::default_arguments::help,
+        false);
+
+    parser.add_argument("directory")
+        .help("directory of test roms, each with an optional <rom>.keys input script");
+    parser.add_argument("-g", "--golden")
+        .help("golden hash file, <directory>/golden.txt by default");
+    parser.add_argument("-c", "--compatibility")
+        .help("implementations to run")
+        .nargs(argparse::nargs_pattern::at_least_one)
+        .default_value(std::vector<std::string>{"default", "schip", "xochip"});
+    parser.add_argument("-u", "--update")
+        .help("record the current hashes as the new golden values")
+        .default_value(false)
+        .implicit_value(true);
+    parser.add_argument("--allow-new")
+        .help("pass runs that have no golden values yet instead of failing them")
+        .default_value(false)
+        .implicit_value(true);
+    parser.add_argument("-f", "--frames")
+        .help("frames to run per rom when recording")
+        .default_value(600u)
+        .scan<'u', unsigned int>();
+    parser.add_argument("-n", "--interval")
+        .help("frames between framebuffer checkpoints when recording")
+        .default_value(60u)
+        .scan<'u', unsigned int>();
+    parser.add_argument("--ipf")
+        .help("instructions per frame when recording")
+        .default_value(30u)
+        .scan<'u', unsigned int>();
+    parser.add_argument("-j", "--jobs")
+        .help("worker threads, all cores by default")
+        .default_value(0u)
+        .scan<'u', unsigned int>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch(const std::runtime_error &e) {
+        std::cout << e.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    auto directory = parser.get("directory");
+    auto goldenPath = parser.present("--golden").value_or(directory + "/golden.txt");
+    bool update = parser.get<bool>("--update");
+    bool allowNew = parser.get<bool>("--allow-new");
+    std::vector<CHIP8_IMPLEMENTATION> implementations;
+    for(auto &name: parser.get<std::vector<std::string>>("--compatibility")) {
+        auto impl = Chip8Factory::fromName(name);
+        if(!impl) {
+            std::cout << "Unknown implementation " << name << std::endl;
+            std::exit(1);
+        }
+        implementations.push_back(impl.value());
+    }
+
+    GoldenValues golden;
+    std::vector<ConformanceJob> jobs;
+    try {
+        if(update) {
+            golden.settings.frames = parser.get<unsigned int>("--frames");
+            golden.settings.checkpointInterval = parser.get<unsigned int>("--interval");
+            golden.settings.instructionsPerFrame = parser.get<unsigned int>("--ipf");
+        } else {
+            golden = readGolden(goldenPath);
+        }
+        jobs = collectJobs(directory, goldenPath, implementations);
+    } catch(std::exception &e) {
+        std::cout << e.what() << std::endl;
+        std::exit(1);
+    }
+
+    auto threadCount = parser.get<unsigned int>("--jobs");
+    if(threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    auto started = Clock::now();
+    auto results = ConformanceSuite(golden.settings).run(jobs, threadCount);
+    std::chrono::duration<double> elapsed = Clock::now() - started;
+
+    if(update) {
+        try {
+            mergeGolden(golden, goldenPath, implementations);
+            for(size_t i = 0; i < jobs.size(); ++i) {
+                auto &hashes = golden.hashes[{jobs[i].romName, Chip8Factory::toName(jobs[i].implementation)}];
+                for(auto &checkpoint: results[i])
+                    hashes[checkpoint.frame] = checkpoint.hash;
+            }
+            writeGolden(goldenPath, golden);
+        } catch(std::runtime_error &e) {
+            std::cout << e.what() << std::endl;
+            std::exit(1);
+        }
+        printf("recorded %zu runs to %s in %.2f s\n", jobs.size(), goldenPath.c_str(), elapsed.count());
+        return 0;
+    }
+
+    size_t passed = 0, failed = 0, missing = 0;
+    for(size_t i = 0; i < jobs.size(); ++i) {
+        auto name = Chip8Factory::toName(jobs[i].implementation);
+        auto expected = golden.hashes.find({jobs[i].romName, name});
+        if(expected == golden.hashes.end()) {
+            printf("NEW  %s %s: no golden values\n", jobs[i].romName.c_str(), name);
+            ++missing;
+            continue;
+        }
+        auto mismatch = std::find_if(results[i].begin(), results[i].end(),
+            [&](const ConformanceCheckpoint &checkpoint) {
+                auto hash = expected->second.find(checkpoint.frame);
+                return hash == expected->second.end() || hash->second != checkpoint.hash;
+            });
+        if(mismatch == results[i].end()) {
+            ++passed;
+            continue;
+        }
+        printf("FAIL %s %s: framebuffer differs at frame %u\n",
+            jobs[i].romName.c_str(), name, mismatch->frame);
+        ++failed;
+    }
+    printf("%zu passed, %zu failed, %zu without golden values in %.2f s on %u threads\n",
+        passed, failed, missing, elapsed.count(), threadCount);
+    if(missing > 0 && !allowNew)
+        printf("runs without golden values fail, record them with --update or pass --allow-new\n");
+    return failed == 0 && (missing == 0 || allowNew) ? 0 : 1;
+}
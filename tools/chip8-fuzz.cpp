@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <utility>
+#include <unistd.h>
+#include <argparse/argparse.hpp>
+#include "FuzzHarness.h"
+#include "RomMutator.h"
+#include "core/RomLoader.h"
+
+typedef std::chrono::steady_clock Clock;
+
+namespace {
+
+std::atomic<uint64_t> executions {0};
+// Read by the watchdog thread and the signal handler
+std::atomic<const FuzzCase *> currentCase {nullptr};
+char crashRomPath[4096];
+char crashKeysPath[4096];
+
+// Only async-signal-safe calls from here on
+void writeAll(int file, const uint8_t *data, size_t size) {
+    while(size > 0) {
+        auto written = write(file, data, size);
+        if(written <= 0)
+            break;
+        data += written;
+        size -= written;
+    }
+}
+
+void writeCrashFile(const char *path, const uint8_t *data, size_t size) {
+    int file = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(file < 0)
+        return;
+    writeAll(file, data, size);
+    close(file);
+}
+
+void saveCurrentCaseAndExit(int signal) {
+    if(auto fuzzCase = currentCase.load()) {
+        writeCrashFile(crashRomPath, fuzzCase->rom.data(), fuzzCase->rom.size());
+        // Same little endian layout as saveCase
+        uint8_t keys[512];
+        size_t length = 0;
+        int file = open(crashKeysPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        for(size_t i = 0; file >= 0 && i < fuzzCase->keys.size(); ++i) {
+            keys[length++] = fuzzCase->keys[i] & 0xFF;
+            keys[length++] = fuzzCase->keys[i] >> 8;
+            if(length == sizeof(keys) || i + 1 == fuzzCase->keys.size()) {
+                writeAll(file, keys, length);
+                length = 0;
+            }
+        }
+        if(file >= 0)
+            close(file);
+    }
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+void startWatchdog(std::chrono::milliseconds timeout) {
+    std::thread([timeout]() {
+        uint64_t lastExecutions = executions.load();
+        auto lastProgress = Clock::now();
+        while(true) {
+            std::this_thread::sleep_for(timeout / 4);
+            auto current = executions.load();
+            if(current != lastExecutions) {
+                lastExecutions = current;
+                lastProgress = Clock::now();
+            } else if(Clock::now() - lastProgress > timeout) {
+                std::cout << "hang: case did not finish within "
+                    << timeout.count() << " ms" << std::endl;
+                saveCurrentCaseAndExit(SIGABRT);
+            }
+        }
+    }).detach();
+}
+
+void saveCase(const std::string &path, const FuzzCase &fuzzCase) {
+    std::ofstream rom(path + ".ch8", std::ios::binary);
+    rom.write(reinterpret_cast<const char *>(fuzzCase.rom.data()), fuzzCase.rom.size());
+    std::ofstream keys(path + ".keys", std::ios::binary);
+    for(auto frameKeys: fuzzCase.keys) {
+        keys.put(frameKeys & 0xFF);
+        keys.put(frameKeys >> 8);
+    }
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    argparse::ArgumentParser parser("chip8-fuzz",
+        "0.1",
+        argparse::default_arguments::help,
+        false);
+
+    parser.add_argument("seeds")
+        .help("rom files used as initial corpus")
+        .nargs(argparse::nargs_pattern::any);
+    parser.add_argument("-c", "--compatibility")
+        .help("implementation to fuzz")
+        .default_value(std::string("default"));
+    parser.add_argument("-o", "--output")
+        .help("directory for findings")
+        .default_value(std::string("."));
+    parser.add_argument("-i", "--instructions")
+        .help("instructions executed per case")
+        .default_value(256u)
+        .scan<'u', unsigned int>();
+    parser.add_argument("-s", "--max-rom-size")
+        .help("maximum size of generated roms")
+        .default_value(256u)
+        .scan<'u', unsigned int>();
+    parser.add_argument("-t", "--time")
+        .help("seconds to run, 0 runs until interrupted")
+        .default_value(0u)
+        .scan<'u', unsigned int>();
+    parser.add_argument("--seed")
+        .help("mutator random seed")
+        .default_value(1u)
+        .scan<'u', unsigned int>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch(const std::runtime_error &e) {
+        std::cout << e.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    auto impl = Chip8Factory::fromName(parser.get("--compatibility"));
+    if(!impl) {
+        std::cout << "Unknown implementation" << std::endl;
+        std::exit(1);
+    }
+    auto instructionsPerCase = parser.get<unsigned int>("--instructions");
+    auto instructionsPerFrame = 11u;
+    auto outputDirectory = parser.get("--output");
+    snprintf(crashRomPath, sizeof(crashRomPath), "%s/crash-signal.ch8", outputDirectory.c_str());
+    snprintf(crashKeysPath, sizeof(crashKeysPath), "%s/crash-signal.keys", outputDirectory.c_str());
+
+    FuzzHarness harness(impl.value(), instructionsPerCase, instructionsPerFrame);
+    RomMutator mutator(parser.get<unsigned int>("--seed"),
+        std::min<size_t>(parser.get<unsigned int>("--max-rom-size"), Chip8Factory::getMaxProgramSize(impl.value())),
+        instructionsPerCase / instructionsPerFrame + 1);
+
+    std::vector<FuzzCase> corpus;
+    for(auto &seedPath: parser.get<std::vector<std::string>>("seeds")) {
+        try {
+            auto rom = RomLoader::load(seedPath);
+            RomLoader::checkFits(rom, impl.value());
+            corpus.push_back({std::vector<uint8_t>(rom.data.begin(), rom.data.begin() + rom.size), {}});
+        } catch(std::runtime_error &e) {
+            std::cout << seedPath << ": " << e.what() << std::endl;
+        }
+    }
+    if(corpus.empty()) {
+        corpus.push_back(mutator.generate());
+    }
+
+    for(auto signal: {SIGSEGV, SIGABRT, SIGFPE, SIGBUS, SIGILL}) {
+        std::signal(signal, saveCurrentCaseAndExit);
+    }
+    startWatchdog(std::chrono::milliseconds(1000));
+
+    std::set<std::pair<FindingKind, uint16_t>> knownFindings;
+    auto started = Clock::now();
+    auto lastReport = started;
+    uint64_t lastReportExecutions = 0;
+    auto timeLimit = std::chrono::seconds(parser.get<unsigned int>("--time"));
+    std::minstd_rand scheduler(parser.get<unsigned int>("--seed"));
+
+    while(timeLimit.count() == 0 || Clock::now() - started < timeLimit) {
+        for(int batch = 0; batch < 1024; ++batch) {
+            auto fuzzCase = scheduler() % 16 == 0
+                ? mutator.generate()
+                : mutator.mutate(corpus[scheduler() % corpus.size()], corpus);
+            currentCase = &fuzzCase;
+            auto result = harness.run(fuzzCase);
+            currentCase = nullptr;
+            executions.fetch_add(1, std::memory_order_relaxed);
+
+            if(result.newCoverage) {
+                corpus.push_back(fuzzCase);
+            }
+            if(!result.finding)
+                continue;
+            auto &finding = result.finding.value();
+            auto key = std::make_pair(finding.kind, classifyOpcode(finding.opcode));
+            if(!knownFindings.insert(key).second)
+                continue;
+            char name[64];
+            snprintf(name, sizeof(name), "%s-%03X-%04X",
+                describeFindingKind(finding.kind), finding.programCounter, finding.opcode);
+            saveCase(outputDirectory + "/" + name, fuzzCase);
+            std::cout << name << ": " << finding.description << std::endl;
+        }
+
+        auto now = Clock::now();
+        if(now - lastReport >= std::chrono::seconds(1)) {
+            std::chrono::duration<double> elapsed = now - lastReport;
+            auto total = executions.load();
+            printf("execs: %lu (%.0f/s) corpus: %zu pc: %zu opcodes: %zu findings: %zu\n",
+                (unsigned long)total,
+                (total - lastReportExecutions) / elapsed.count(),
+                corpus.size(),
+                harness.getProgramCounterCoverage(),
+                harness.getOpcodeCoverage(),
+                knownFindings.size());
+            fflush(stdout);
+            lastReport = now;
+            lastReportExecutions = total;
+        }
+    }
+    return knownFindings.empty() ? 0 : 1;
+}
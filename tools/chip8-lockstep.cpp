@@ -0,0 +1,111 @@
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <argparse/argparse.hpp>
+#include "core/Chip8Factory.h"
+#include "core/Lockstep.h"
+#include "core/RomLoader.h"
+
+constexpr uint32_t LOCKSTEP_RANDOM_SEED = 0xC8C8C8C8;
+
+void printWindow(const char *name, const std::vector<TraceRecord> &window) {
+    printf("%s, last %zu instructions:\n", name, window.size());
+    for(auto &record: window) {
+        printf("  %03X %04X I=%03X", record.programCounter, record.opcode, record.indexPointer);
+        for(int i = 0; i < 16; ++i) {
+            if(record.changedRegisters & (1 << i))
+                printf(" V%X=%02X", i, record.variables[i]);
+        }
+        printf("\n");
+    }
+}
+
+CHIP8_IMPLEMENTATION parseImplementation(const std::string &name) {
+    auto impl = Chip8Factory::fromName(name);
+    if(!impl) {
+        std::cout << "Unknown implementation " << name << std::endl;
+        std::exit(1);
+    }
+    return impl.value();
+}
+
+int main(int argc, char *argv[]) {
+    argparse::ArgumentParser parser("chip8-lockstep",
+        "0.1",
+        argparse::default_arguments::help,
+        false);
+
+    parser.add_argument("files")
+        .help("rom files to run")
+        .nargs(argparse::nargs_pattern::at_least_one);
+    parser.add_argument("-r", "--reference")
+        .help("reference implementation")
+        .default_value(std::string("default"));
+    parser.add_argument("-c", "--candidate")
+        .help("candidate implementation")
+        .default_value(std::string("default"));
+    parser.add_argument("-n", "--interval")
+        .help("compare memory and framebuffer every n instructions, registers always")
+        .default_value(LOCKSTEP_DEFAULT_COMPARE_INTERVAL)
+        .scan<'u', unsigned int>();
+    parser.add_argument("-i", "--instructions")
+        .help("instructions to run per rom")
+        .default_value(1000000u)
+        .scan<'u', unsigned int>();
+    parser.add_argument("-f", "--instructions-per-frame")
+        .help("instructions between timer ticks")
+        .default_value(11u)
+        .scan<'u', unsigned int>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch(const std::runtime_error &e) {
+        std::cout << e.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    auto referenceImpl = parseImplementation(parser.get("--reference"));
+    auto candidateImpl = parseImplementation(parser.get("--candidate"));
+    Chip8Keyboard keyboard {};
+
+    int diverged = 0;
+    for(auto &romFilePath: parser.get<std::vector<std::string>>("files")) {
+        RomImage rom;
+        try {
+            rom = RomLoader::load(romFilePath);
+            RomLoader::checkFits(rom, referenceImpl);
+            RomLoader::checkFits(rom, candidateImpl);
+        } catch(std::runtime_error &e) {
+            std::cout << romFilePath << ": " << e.what() << std::endl;
+            ++diverged;
+            continue;
+        }
+        auto reference = Chip8Factory::make(referenceImpl, keyboard);
+        auto candidate = Chip8Factory::make(candidateImpl, keyboard);
+        for(auto chip8: {reference.get(), candidate.get()}) {
+            chip8->seedRandom(LOCKSTEP_RANDOM_SEED);
+            chip8->loadRom(rom.data);
+        }
+
+        LockstepRunner runner(*reference, *candidate,
+            parser.get<unsigned int>("--interval"),
+            parser.get<unsigned int>("--instructions-per-frame"));
+        auto divergence = runner.run(parser.get<unsigned int>("--instructions"));
+        if(!divergence) {
+            std::cout << romFilePath << ": OK" << std::endl;
+            continue;
+        }
+
+        ++diverged;
+        std::cout << romFilePath << ": diverged before instruction "
+            << divergence->instruction << std::endl;
+        for(auto &difference: divergence->differences) {
+            std::cout << "  " << difference << std::endl;
+        }
+        printWindow("reference", divergence->referenceWindow);
+        printWindow("candidate", divergence->candidateWindow);
+    }
+    return diverged == 0 ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <argparse/argparse.hpp>
+#include "core/CaptureFormat.h"
+#include "core/Replay.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// A chip for one worker, in the recorded implementation. Logged traps were
+// printed during the session already.
+struct ReplayPlayer {
+    Chip8Keyboard keyboard {};
+    std::unique_ptr<Chip8> chip8;
+
+    ReplayPlayer(const ReplayFile &replay):
+        chip8(Chip8Factory::make(replay.getImplementation(), keyboard)) {
+        auto policy = replay.getTrapPolicy();
+        chip8->setTrapPolicy(policy == CHIP8_TRAP_LOG ? CHIP8_TRAP_SKIP : policy);
+    }
+};
+
+// Rethrows the first exception a worker ran into once all have stopped
+void forEachParallel(size_t count, unsigned int threadCount, const std::function<void(size_t)> &work) {
+    std::atomic<size_t> next {0};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto worker = [&]() {
+        for(auto i = next++; i < count; i = next++) {
+            try {
+                work(i);
+            } catch(...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if(!error)
+                    error = std::current_exception();
+                next = count;
+            }
+        }
+    };
+    threadCount = std::max(1u, std::min<unsigned int>(threadCount, count));
+    std::vector<std::thread> threads;
+    for(unsigned int i = 1; i < threadCount; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for(auto &thread: threads)
+        thread.join();
+    if(error)
+        std::rethrow_exception(error);
+}
+
+void printInfo(const ReplayFile &replay) {
+    auto &segments = replay.getSegments();
+    size_t resets = std::count_if(segments.begin(), segments.end(),
+        [](const ReplaySegment &segment) { return segment.flags & REPLAY_SEGMENT_RESET; });
+    printf("%s, %u frames (%.1f s), %zu segments, checkpoint every %u frames, %zu rom loads\n",
+        Chip8Factory::toName(replay.getImplementation()), replay.getFrameCount(),
+        replay.getFrameCount() / double(CAPTURE_FRAME_RATE), segments.size(),
+        replay.getCheckpointInterval(), resets);
+}
+
+void printState(const Chip8 &chip8) {
+    printf("PC=%03X I=%03X cycles=%llu\n", chip8.getProgramCounter(), chip8.getIndexPointer(),
+        static_cast<unsigned long long>(chip8.getCycleCount()));
+    for(int i = 0; i < 16; ++i)
+        printf("V%X=%02X%c", i, chip8.getRegister(i), i % 8 == 7 ? '\n' : ' ');
+    printf("stack:");
+    for(auto address: chip8.getStack())
+        printf(" %03X", address);
+    printf("\n");
+}
+
+// Segments are replayed by the workers a batch at a time, each into its own
+// list of deduplicated frames, and encoded in order on this thread. Only a
+// batch of frame lists is held in memory however long the replay is.
+void render(const ReplayFile &replay, const std::string &path, uint32_t from, uint32_t to,
+    unsigned int threadCount) {
+    auto encoder = CaptureEncoder::open(path);
+    auto &segments = replay.getSegments();
+    auto first = replay.findSegment(from);
+    auto last = replay.findSegment(to - 1) + 1;
+    std::vector<std::vector<CaptureFrame>> batch(threadCount);
+    CaptureFrame pending;
+    bool hasPending = false;
+    for(auto batchStart = first; batchStart < last; batchStart += threadCount) {
+        auto batchSize = std::min<size_t>(threadCount, last - batchStart);
+        forEachParallel(batchSize, threadCount, [&](size_t i) {
+            auto &segment = segments[batchStart + i];
+            auto &frames = batch[i];
+            frames.clear();
+            ReplayPlayer player(replay);
+            replay.loadCheckpoint(segment, *player.chip8);
+            auto end = std::min(to, segment.firstFrame + segment.frameCount);
+            for(auto frame = segment.firstFrame; frame < end; ++frame) {
+                replay.playFrame(segment, frame, *player.chip8, player.keyboard);
+                if(frame < from)
+                    continue;
+                auto pixels = player.chip8->peek();
+                if(!frames.empty() && frames.back().pixels == pixels)
+                    ++frames.back().duration;
+                else
+                    frames.push_back({pixels, 1});
+            }
+        });
+        for(size_t i = 0; i < batchSize; ++i) {
+            for(auto &frame: batch[i]) {
+                if(hasPending && pending.pixels == frame.pixels) {
+                    pending.duration += frame.duration;
+                    continue;
+                }
+                if(hasPending)
+                    encoder->writeFrame(pending);
+                pending = frame;
+                hasPending = true;
+            }
+        }
+    }
+    if(hasPending)
+        encoder->writeFrame(pending);
+    encoder->finish();
+}
+
+// Replays every segment from its checkpoint and compares the result with the
+// checkpoint that follows it. Returns the number of segments that disagree.
+size_t verify(const ReplayFile &replay, unsigned int threadCount) {
+    auto &segments = replay.getSegments();
+    std::vector<uint8_t> results(segments.size(), true);
+    forEachParallel(segments.size() - 1, threadCount, [&](size_t i) {
+        auto &segment = segments[i];
+        auto &next = segments[i + 1];
+        if(next.flags & REPLAY_SEGMENT_RESET)
+            return;
+        ReplayPlayer player(replay);
+        replay.loadCheckpoint(segment, *player.chip8);
+        for(auto frame = segment.firstFrame; frame < next.firstFrame; ++frame)
+            replay.playFrame(segment, frame, *player.chip8, player.keyboard);
+        ReplayPlayer expected(replay);
+        replay.loadCheckpoint(next, *expected.chip8);
+        Chip8State state;
+        std::vector<uint8_t> played, recorded;
+        player.chip8->saveState(state);
+        serializeState(state, played);
+        expected.chip8->saveState(state);
+        serializeState(state, recorded);
+        results[i] = played == recorded;
+    });
+    size_t failed = 0;
+    for(size_t i = 0; i + 1 < segments.size(); ++i) {
+        if(results[i])
+            continue;
+        printf("FAIL frames %u-%u do not replay to the next checkpoint\n",
+            segments[i].firstFrame, segments[i + 1].firstFrame);
+        ++failed;
+    }
+    return failed;
+}
+
+int main(int argc, char *argv[]) {
+    argparse::ArgumentParser parser("chip8-replay",
+        "0.1",
+        argparse::default_arguments::help,
+        false);
+
+    parser.add_argument("file")
+        .help("replay recorded with chip8-emulator --record");
+    parser.add_argument("-s", "--seek")
+        .help("print the machine state before this frame")
+        .scan<'u', unsigned int>();
+    parser.add_argument("-r", "--render")
+        .help("render frames to a .gif, .png (animated) or .y4m file");
+    parser.add_argument("--from")
+        .help("first frame to render")
+        .default_value(0u)
+        .scan<'u', unsigned int>();
+    parser.add_argument("--to")
+        .help("frame to stop rendering at, the end by default")
+        .scan<'u', unsigned int>();
+    parser.add_argument("--verify")
+        .help("check that every segment replays to the checkpoint after it")
+        .default_value(false)
+        .implicit_value(true);
+    parser.add_argument("-j", "--jobs")
+        .help("worker threads, all cores by default")
+        .default_value(0u)
+        .scan<'u', unsigned int>();
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch(const std::runtime_error &e) {
+        std::cout << e.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    auto threadCount = parser.get<unsigned int>("--jobs");
+    if(threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    int exitCode = 0;
+    try {
+        auto started = Clock::now();
+        ReplayFile replay(parser.get("file"));
+        std::chrono::duration<double, std::milli> opened = Clock::now() - started;
+        printInfo(replay);
+        printf("opened in %.2f ms\n", opened.count());
+
+        if(auto frame = parser.present<unsigned int>("--seek")) {
+            if(frame.value() > replay.getFrameCount())
+                throw ReplayFileException("frame " + std::to_string(frame.value()) + " is past the end");
+            started = Clock::now();
+            ReplayPlayer player(replay);
+            replay.seek(*player.chip8, player.keyboard, frame.value());
+            std::chrono::duration<double, std::milli> elapsed = Clock::now() - started;
+            printf("frame %u, reached in %.2f ms\n", frame.value(), elapsed.count());
+            printState(*player.chip8);
+        }
+        if(auto renderPath = parser.present("--render")) {
+            auto from = parser.get<unsigned int>("--from");
+            auto to = std::min(parser.present<unsigned int>("--to").value_or(replay.getFrameCount()),
+                replay.getFrameCount());
+            if(from >= to)
+                throw ReplayFileException("nothing to render between frames "
+                    + std::to_string(from) + " and " + std::to_string(to));
+            started = Clock::now();
+            render(replay, renderPath.value(), from, to, threadCount);
+            std::chrono::duration<double> elapsed = Clock::now() - started;
+            printf("rendered frames %u-%u to %s in %.2f s on %u threads\n",
+                from, to, renderPath->c_str(), elapsed.count(), threadCount);
+        }
+        if(parser.get<bool>("--verify")) {
+            started = Clock::now();
+            auto failed = verify(replay, threadCount);
+            std::chrono::duration<double> elapsed = Clock::now() - started;
+            printf("%zu of %zu segments diverge, checked in %.2f s on %u threads\n",
+                failed, replay.getSegments().size() - 1, elapsed.count(), threadCount);
+            exitCode = failed == 0 ? 0 : 1;
+        }
+    } catch(std::runtime_error &e) {
+        std::cout << e.what() << std::endl;
+        std::exit(1);
+    }
+    return exitCode;
+}
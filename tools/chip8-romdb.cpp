@@ -0,0 +1,104 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <argparse/argparse.hpp>
+#include "core/Chip8Factory.h"
+#include "core/RomDatabase.h"
+#include "core/RomLoader.h"
+
+// Source format, one rom per line, # starts a comment:
+//   <rom file or 16 digit hex hash> <compatibility> <instructions per frame> [keys]
+// keys lists the keyboard key for CHIP-8 keys 0 to F, e.g. x123qweasdzc4rfv
+RomDatabaseEntry parseLine(const std::string &line) {
+    std::istringstream fields(line);
+    std::string rom, compatibility, keys;
+    unsigned int instructionsPerFrame = 0;
+    if(!(fields >> rom >> compatibility >> instructionsPerFrame))
+        throw std::runtime_error("expected: rom compatibility instructions-per-frame [keys]");
+    fields >> keys;
+
+    RomDatabaseEntry entry {};
+    if(std::ifstream(rom).good()) {
+        entry.hash = RomLoader::load(rom).hash;
+    } else if(rom.size() == 16) {
+        entry.hash = std::stoull(rom, nullptr, 16);
+    } else {
+        throw std::runtime_error("no such rom file " + rom);
+    }
+    auto impl = Chip8Factory::fromName(compatibility);
+    if(!impl)
+        throw std::runtime_error("unknown compatibility mode " + compatibility);
+    entry.implementation = impl.value();
+    entry.instructionsPerFrame = instructionsPerFrame;
+    if(!keys.empty() && keys.size() != sizeof(entry.keyMapping))
+        throw std::runtime_error("keys must list 16 keys");
+    memcpy(entry.keyMapping, keys.data(), keys.size());
+    return entry;
+}
+
+int main(int argc, char *argv[]) {
+    argparse::ArgumentParser parser("chip8-romdb",
+        "0.1",
+        argparse::default_arguments::help,
+        false);
+
+    parser.add_argument("files")
+        .help("database source files, or roms with --hash")
+        .nargs(argparse::nargs_pattern::at_least_one);
+    parser.add_argument("-o", "--output")
+        .help("index file to write")
+        .default_value(std::string("roms.c8db"));
+    parser.add_argument("--hash")
+        .help("print content hashes of roms instead")
+        .default_value(false)
+        .implicit_value(true);
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch(const std::runtime_error &e) {
+        std::cout << e.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    auto files = parser.get<std::vector<std::string>>("files");
+    if(parser.get<bool>("--hash")) {
+        for(auto &file: files) {
+            try {
+                printf("%016" PRIx64 " %s\n", RomLoader::load(file).hash, file.c_str());
+            } catch(std::runtime_error &e) {
+                std::cout << file << ": " << e.what() << std::endl;
+            }
+        }
+        return 0;
+    }
+
+    std::vector<RomDatabaseEntry> entries;
+    for(auto &file: files) {
+        std::ifstream source(file);
+        if(!source.good()) {
+            std::cout << file << ": could not open" << std::endl;
+            std::exit(1);
+        }
+        std::string line;
+        for(int lineNumber = 1; std::getline(source, line); ++lineNumber) {
+            line = line.substr(0, line.find('#'));
+            if(line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+            try {
+                entries.push_back(parseLine(line));
+            } catch(std::exception &e) {
+                std::cout << file << ":" << lineNumber << ": " << e.what() << std::endl;
+                std::exit(1);
+            }
+        }
+    }
+    RomDatabase::write(parser.get("--output"), entries);
+    std::cout << "Wrote " << entries.size() << " roms to " << parser.get("--output") << std::endl;
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <argparse/argparse.hpp>
+#include "core/TraceFormat.h"
+
+struct OpcodePattern {
+    uint16_t mask = 0;
+    uint16_t value = 0;
+};
+
+struct AddressRange {
+    uint16_t first = 0;
+    uint16_t last = 0xFFFF;
+};
+
+OpcodePattern parseOpcodePattern(const std::string &text) {
+    if(text.size() != 4)
+        throw std::runtime_error("Opcode pattern must have 4 hex digits, use x as wildcard");
+    OpcodePattern pattern;
+    for(auto c: text) {
+        pattern.mask <<= 4;
+        pattern.value <<= 4;
+        if(c == 'x' || c == 'X')
+            continue;
+        pattern.mask |= 0xF;
+        pattern.value |= std::stoi(std::string(1, c), nullptr, 16);
+    }
+    return pattern;
+}
+
+AddressRange parseAddressRange(const std::string &text) {
+    AddressRange range;
+    auto separator = text.find('-');
+    range.first = std::stoi(text.substr(0, separator), nullptr, 16);
+    range.last = separator == std::string::npos
+        ? range.first
+        : std::stoi(text.substr(separator + 1), nullptr, 16);
+    return range;
+}
+
+void printRecord(uint16_t stream, const TraceRecord &record) {
+    printf("%u %03X %04X I=%03X VF=%02X", stream, record.programCounter,
+        record.opcode, record.indexPointer, record.variables[0xF]);
+    for(int i = 0; i < 0xF; ++i) {
+        if(record.changedRegisters & (1 << i))
+            printf(" V%X=%02X", i, record.variables[i]);
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    argparse::ArgumentParser parser("chip8-trace",
+        "0.1",
+        argparse::default_arguments::help,
+        false);
+
+    parser.add_argument("file")
+        .help("trace file recorded with --trace");
+    parser.add_argument("-a", "--address")
+        .help("only show instructions at address or range, e.g. 2A0 or 200-2FF");
+    parser.add_argument("-o", "--opcode")
+        .help("only show opcodes matching pattern, e.g. Dxxx or Fx55");
+
+    try {
+        parser.parse_args(argc, argv);
+    } catch(const std::runtime_error &e) {
+        std::cout << e.what() << std::endl;
+        std::cerr << parser;
+        std::exit(1);
+    }
+
+    AddressRange addresses;
+    OpcodePattern opcodes;
+    try {
+        if(auto address = parser.present("-a"))
+            addresses = parseAddressRange(address.value());
+        if(auto opcode = parser.present("-o"))
+            opcodes = parseOpcodePattern(opcode.value());
+    } catch(const std::exception &e) {
+        std::cout << e.what() << std::endl;
+        std::exit(1);
+    }
+
+    auto file = fopen(parser.get("file").c_str(), "rb");
+    if(file == nullptr) {
+        std::cout << "Could not open trace file" << std::endl;
+        std::exit(1);
+    }
+
+    uint8_t header[TRACE_HEADER_SIZE];
+    if(fread(header, 1, sizeof(header), file) != sizeof(header)
+        || memcmp(header, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0) {
+        std::cout << "Not a chip8 trace file" << std::endl;
+        std::exit(1);
+    }
+    bool compressed = (header[6] | (header[7] << 8)) & TRACE_FLAG_COMPRESSED;
+
+    std::unordered_map<uint16_t, TraceDecoder> decoders;
+    std::vector<uint8_t> payload;
+    uint8_t blockHeader[TRACE_BLOCK_HEADER_SIZE];
+    try {
+        while(fread(blockHeader, 1, sizeof(blockHeader), file) == sizeof(blockHeader)) {
+            uint16_t stream = blockHeader[0] | (blockHeader[1] << 8);
+            uint32_t recordCount = blockHeader[2] | (blockHeader[3] << 8)
+                | (blockHeader[4] << 16) | ((uint32_t)blockHeader[5] << 24);
+            uint32_t payloadSize = blockHeader[6] | (blockHeader[7] << 8)
+                | (blockHeader[8] << 16) | ((uint32_t)blockHeader[9] << 24);
+            payload.resize(payloadSize);
+            if(fread(payload.data(), 1, payloadSize, file) != payloadSize)
+                throw CorruptedTraceException();
+
+            auto &decoder = decoders.try_emplace(stream, compressed).first->second;
+            const uint8_t *data = payload.data();
+            const uint8_t *end = data + payload.size();
+            TraceRecord record;
+            for(uint32_t i = 0; i < recordCount; ++i) {
+                data = decoder.decode(data, end, record);
+                if(record.programCounter < addresses.first
+                    || record.programCounter > addresses.last)
+                    continue;
+                if((record.opcode & opcodes.mask) != opcodes.value)
+                    continue;
+                printRecord(stream, record);
+            }
+        }
+    } catch(const CorruptedTraceException &e) {
+        std::cout << e.what() << std::endl;
+        fclose(file);
+        std::exit(1);
+    }
+    fclose(file);
+    return 0;
+}